@@ -0,0 +1,179 @@
+// Runs a Lua script against RecordingGLBackend, without a window or GL
+// context, and reports what the GL bindings did:
+//
+//   OxygenCrateLuaHeadless <script.lua> [frames]
+//
+// The script must return its table of callbacks, as it does for
+// LuaScriptHost. It is loaded once, then its update and render functions
+// (under the same names the host accepts) run for the given number of frames
+// (60 by default). draw() is skipped because it needs ImGui. Exits with 1 when
+// the script fails, has no render function or deletes an object it does not
+// own; objects still alive at the end are listed as leaks.
+#include "Panels/LuaPanels/GLBackend.hpp"
+#include "Panels/LuaPanels/LuaGLBindings.hpp"
+#include "Panels/LuaPanels/RecordingGLBackend.hpp"
+
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace
+{
+    const char* ObjectTypeName(GLDeletionQueue::ObjectType type)
+    {
+        switch (type)
+        {
+        case GLDeletionQueue::ObjectType::Buffer: return "buffer";
+        case GLDeletionQueue::ObjectType::VertexArray: return "vertex array";
+        case GLDeletionQueue::ObjectType::Program: return "program";
+        case GLDeletionQueue::ObjectType::Texture: return "texture";
+        case GLDeletionQueue::ObjectType::Renderbuffer: return "renderbuffer";
+        case GLDeletionQueue::ObjectType::Framebuffer: return "framebuffer";
+        }
+        return "object";
+    }
+
+    // Same lookup as LuaScriptHost::CompileScript.
+    sol::protected_function FindScriptFunction(const sol::table& script, const std::array<const char*, 3>& names)
+    {
+        for (const char* name : names)
+        {
+            sol::object candidate = script[name];
+            if (candidate.valid() && candidate.get_type() == sol::type::function)
+                return candidate.as<sol::protected_function>();
+        }
+        return sol::protected_function{};
+    }
+
+    bool CallScriptFunction(const sol::protected_function& function, const char* name, float deltaTime)
+    {
+        if (!function.valid())
+            return true;
+
+        sol::protected_function_result result = function(deltaTime);
+        if (result.valid())
+            return true;
+
+        sol::error err = result;
+        std::fprintf(stderr, "[Error] %s: %s\n", name, err.what());
+        return false;
+    }
+
+    // Lets require("modules.X") resolve against the bundled modules and the
+    // script's own directory regardless of the working directory.
+    void AddModulePaths(sol::state& lua, const std::filesystem::path& scriptPath)
+    {
+        std::string paths;
+        for (const std::filesystem::path& dir : { scriptPath.parent_path(), std::filesystem::path(OXYGENCRATE_LUA_ASSET_DIR) })
+        {
+            const std::string base = (dir.empty() ? std::filesystem::path(".") : dir).generic_string();
+            paths += base + "/?.lua;" + base + "/?/init.lua;";
+        }
+        sol::table packageTable = lua["package"];
+        packageTable["path"] = paths + packageTable.get_or("path", std::string{});
+    }
+
+    bool PollShaders()
+    {
+        bool ok = true;
+        for (const std::string& message : LuaGLBindings::PollPendingShaders())
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            ok = false;
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <script.lua> [frames]\n", argv[0]);
+        return 2;
+    }
+    const int frames = argc > 2 ? std::max(0, std::atoi(argv[2])) : 60;
+    const float deltaTime = 1.0f / 60.0f;
+
+    RecordingGLBackend backend;
+    // Only the counters are reported, so keep the call log from growing.
+    backend.SetCallLimit(1);
+    GLBackend::SetActive(&backend);
+
+    bool ok = true;
+    {
+        sol::state lua;
+        lua.open_libraries(sol::lib::base,
+            sol::lib::math,
+            sol::lib::string,
+            sol::lib::os,
+            sol::lib::package,
+            sol::lib::table);
+        AddModulePaths(lua, argv[1]);
+        LuaGLBindings::Register(lua);
+
+        sol::protected_function update;
+        sol::protected_function render;
+        sol::protected_function_result loaded = lua.safe_script_file(argv[1], sol::script_pass_on_error);
+        if (!loaded.valid())
+        {
+            sol::error err = loaded;
+            std::fprintf(stderr, "[Error] %s\n", err.what());
+            ok = false;
+        }
+        else
+        {
+            sol::object returnValue = loaded;
+            if (returnValue.is<sol::table>())
+            {
+                const sol::table script = returnValue.as<sol::table>();
+                update = FindScriptFunction(script, { "update", "on_update", "onUpdate" });
+                render = FindScriptFunction(script, { "render", "on_render", "onRender" });
+            }
+            else
+            {
+                std::fprintf(stderr, "[Error] script must return a table of callbacks\n");
+                ok = false;
+            }
+        }
+        if (ok && !render.valid())
+        {
+            std::fprintf(stderr, "[Error] returned table has no render function; nothing would be drawn\n");
+            ok = false;
+        }
+        if (ok && !update.valid())
+            std::fprintf(stderr, "[Warning] returned table has no update function\n");
+
+        for (int frame = 0; ok && frame < frames; ++frame)
+        {
+            LuaGLBindings::BeginFrame();
+            ok = PollShaders();
+            ok = ok && CallScriptFunction(update, "update", deltaTime);
+            ok = ok && CallScriptFunction(render, "render", deltaTime);
+        }
+        ok = PollShaders() && ok;
+
+        LuaGLBindings::ReleaseScriptReferences();
+        LuaGLBindings::ReleaseAll();
+    }
+
+    std::map<std::string, size_t> leaks;
+    for (const RecordingGLBackend::LiveObject& object : backend.GetLiveObjects())
+        ++leaks[ObjectTypeName(object.Type)];
+
+    std::printf("calls: %zu\n", backend.GetCallCount());
+    std::printf("draws: %zu\n", backend.GetDrawCount());
+    std::printf("uploaded bytes: %zu\n", backend.GetUploadedBytes());
+    std::printf("live objects: %zu\n", backend.GetLiveObjects().size());
+    for (const auto& [type, count] : leaks)
+        std::printf("  %s: %zu\n", type.c_str(), count);
+    std::printf("invalid deletes: %zu\n", backend.GetInvalidDeleteCount());
+
+    GLBackend::SetActive(nullptr);
+    return ok && backend.GetInvalidDeleteCount() == 0 ? 0 : 1;
+}
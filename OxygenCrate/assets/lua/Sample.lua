@@ -1,16 +1,15 @@
 -- Lua + OpenGL sample: render a user-controlled triangle into a Flux::Image.
 -- Demonstrates building vertex buffers from ImGui input and drawing with vertex colors.
+-- Vertices are packed to 12 bytes: two floats for the position and four normalized bytes for the color.
 
-local VertexArray = require("modules.VertexArray")
-local VertexBuffer = require("modules.VertexBuffer")
-local IndexBuffer = require("modules.IndexBuffer")
+local Mesh = require("modules.Mesh")
 local BufferLayout = require("modules.BufferLayout")
 local Shader = require("modules.Shader")
+local QuadBatch = require("modules.QuadBatch")
 local gl = opengles or opengl
 local flux = flux_image
-local GL_FLOAT = 0x1406
-local GL_UNSIGNED_INT = 0x1405
-local GL_TRIANGLES = 0x0004
+local GL_FLOAT = BufferLayout.types.FLOAT
+local GL_UNSIGNED_BYTE = BufferLayout.types.UNSIGNED_BYTE
 local GL_COLOR_BUFFER_BIT = 0x00004000
 local GL_DYNAMIC_DRAW = 0x88E8
 
@@ -28,6 +27,7 @@ end
 local ui = {
     window = { open = true },
     size = { 256, 256 },
+    requested_size = nil,
     background = { 0.05, 0.05, 0.08, 1.0 },
     image_buffers = nil,
     front_buffer = 1,
@@ -46,25 +46,17 @@ local function build_vertex_stream(target, controls)
         local color = entry.color
         vertices[base + 1] = position[1]
         vertices[base + 2] = position[2]
-        vertices[base + 3] = 0.0
-        vertices[base + 4] = color[1]
-        vertices[base + 5] = color[2]
-        vertices[base + 6] = color[3]
+        vertices[base + 3] = color[1]
+        vertices[base + 4] = color[2]
+        vertices[base + 5] = color[3]
+        vertices[base + 6] = 1.0
     end
     return vertices
 end
 
 local function upload_vertex_stream(resources, controls)
     resources.dynamic_vertices = build_vertex_stream(resources.dynamic_vertices, controls)
-    local data = resources.dynamic_vertices
-    if resources.vbo then
-        resources.vbo:set_data(data, GL_DYNAMIC_DRAW)
-    else
-        resources.vbo = VertexBuffer.new(data, GL_DYNAMIC_DRAW)
-        resources.vao:bind()
-        resources.vbo:bind()
-        resources.layout:apply()
-    end
+    resources.mesh:set_vertices(resources.dynamic_vertices)
 end
 
 local function reset_vertex_controls()
@@ -79,11 +71,14 @@ local function ensure_resources()
         return
     end
 
+    -- Render targets come from a pool and are resized in place, so following
+    -- the panel width does not allocate new images.
+    local target_options = { samples = 4 }
     ui.image_buffers = {
-        create_image(ui.size[1], ui.size[2]),
-        create_image(ui.size[1], ui.size[2]),
+        create_render_target(ui.size[1], ui.size[2], target_options),
+        create_render_target(ui.size[1], ui.size[2], target_options),
     }
-    if not ui.image_buffers[1] or not ui.image_buffers[2] then
+    if ui.image_buffers[1] < 0 or ui.image_buffers[2] < 0 then
         ui.image_buffers = nil
         return
     end
@@ -92,32 +87,61 @@ local function ensure_resources()
 
     local indices = { 0, 1, 2 }
 
-    local vao = VertexArray.new()
-    vao:bind()
-
     local layout = BufferLayout.new({
-        { index = 0, size = 3, type = GL_FLOAT, normalized = false },
-        { index = 1, size = 3, type = GL_FLOAT, normalized = false },
+        { index = 0, size = 2, type = GL_FLOAT, normalized = false },
+        { index = 1, size = 4, type = GL_UNSIGNED_BYTE, normalized = true },
     })
 
-    local ebo = IndexBuffer.new(indices)
-    ebo:bind()
+    local dynamic_vertices = build_vertex_stream(nil, ui.vertex_controls)
+    local mesh = Mesh.new(layout, dynamic_vertices, indices, { usage = GL_DYNAMIC_DRAW })
 
     local isGLES = (opengles ~= nil)
     local shader_folder = isGLES and "shaders/opengles" or "shaders/opengl"
     local shader = Shader.from_files(shader_folder .. "/simple.vert", shader_folder .. "/simple.frag")
 
+    -- Overlay plot drawn with the native quad batcher.
+    local batch_shader = Shader.from_files(shader_folder .. "/quad_batch.vert", shader_folder .. "/quad_batch.frag")
+
     ui.resources = {
-        vao = vao,
-        vbo = nil,
-        ebo = ebo,
+        mesh = mesh,
         shader = shader,
-        layout = layout,
-        index_count = #indices,
-        dynamic_vertices = nil,
+        dynamic_vertices = dynamic_vertices,
+        batch = QuadBatch.new(),
+        batch_shader = batch_shader,
     }
+end
 
-    upload_vertex_stream(ui.resources, ui.vertex_controls)
+local function apply_requested_size()
+    local requested = ui.requested_size
+    if not requested or (requested == ui.size[1] and requested == ui.size[2]) then
+        return
+    end
+    for _, target in ipairs(ui.image_buffers) do
+        resize_render_target(target, requested, requested)
+    end
+    ui.size[1], ui.size[2] = requested, requested
+end
+
+-- A scrolling sine plot: one line per segment, all flushed in a single draw.
+local function draw_overlay(res, t)
+    local width, height = ui.size[1], ui.size[2]
+    local batch = res.batch
+    batch:set_viewport(width, height)
+    batch:set_state(res.batch_shader)
+
+    local baseline = height * 0.85
+    local amplitude = height * 0.08
+    local segments = 64
+    local step = width / segments
+    batch:line(0, baseline, width, baseline, 1, 0xFFFFFF40)
+    local previous_y = baseline - amplitude * sin(t * 2.0)
+    for i = 1, segments do
+        local x = i * step
+        local y = baseline - amplitude * sin(t * 2.0 + i * 0.2)
+        batch:line(x - step, previous_y, x, y, 2, 0x66CCFFFF)
+        previous_y = y
+    end
+    batch:flush()
 end
 
 local function render_triangle()
@@ -125,6 +149,8 @@ local function render_triangle()
         return false
     end
 
+    apply_requested_size()
+
     upload_vertex_stream(ui.resources, ui.vertex_controls)
 
     local target_image = ui.image_buffers[ui.back_buffer]
@@ -144,8 +170,8 @@ local function render_triangle()
     local res = ui.resources
     res.shader:use()
     res.shader:set_float("u_Time", pi * 0.5)
-    res.vao:bind()
-    gl.draw_elements(GL_TRIANGLES, res.index_count, GL_UNSIGNED_INT, 0)
+    res.mesh:draw()
+    draw_overlay(res, t)
 
     flux.unbind_framebuffer()
     return true
@@ -235,7 +261,9 @@ function ui.render(delta_time)
         return
     end
     ui.time_accumulator = ui.time_accumulator + delta_time
+    gl.begin_timer("triangle")
     local rendered = render_triangle()
+    gl.end_timer()
     if rendered then
         ui.front_buffer, ui.back_buffer = ui.back_buffer, ui.front_buffer
     end
@@ -260,12 +288,19 @@ function ui.draw()
             if display_image then
                 imgui.separator()
                 imgui.text("Rendered image:")
+                local available = imgui.get_content_region_avail()
+                ui.requested_size = math.max(64, math.min(512, math.floor(available)))
                 imgui.image(display_image, ui.size[1], ui.size[2])
             else
                 imgui.text("Front buffer unavailable.")
             end
 
             imgui.text(string.format("FPS: %.2f", current_fps()))
+            local cpu_ms, gpu_ms = gl.timer_result("triangle")
+            if cpu_ms then
+                local gpu_text = gpu_ms and string.format("%.3f ms", gpu_ms) or "n/a"
+                imgui.text(string.format("Triangle pass: CPU %.3f ms, GPU %s", cpu_ms, gpu_text))
+            end
         end
     end
     imgui.end_window()
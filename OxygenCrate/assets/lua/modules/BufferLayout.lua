@@ -1,15 +1,39 @@
 local gl = rawget(_G, "opengles") or rawget(_G, "opengl")
 assert(gl, "OpenGL bindings are not available in Lua")
 
+local types = {
+    FLOAT = 0x1406,
+    HALF_FLOAT = 0x140B,
+    INT = 0x1404,
+    UNSIGNED_INT = 0x1405,
+    SHORT = 0x1402,
+    UNSIGNED_SHORT = 0x1403,
+    BYTE = 0x1400,
+    UNSIGNED_BYTE = 0x1401,
+    INT_2_10_10_10_REV = 0x8D9F,
+    UNSIGNED_INT_2_10_10_10_REV = 0x8368,
+}
+
 local typeSizes = {
-    [0x1406] = 4, -- GL_FLOAT
-    [0x1404] = 4, -- GL_INT
-    [0x1405] = 4, -- GL_UNSIGNED_INT
-    [0x1401] = 1, -- GL_UNSIGNED_BYTE
+    [types.FLOAT] = 4,
+    [types.HALF_FLOAT] = 2,
+    [types.INT] = 4,
+    [types.UNSIGNED_INT] = 4,
+    [types.SHORT] = 2,
+    [types.UNSIGNED_SHORT] = 2,
+    [types.BYTE] = 1,
+    [types.UNSIGNED_BYTE] = 1,
+}
+
+-- 2_10_10_10 formats pack all four components into one 32-bit word.
+local packedTypes = {
+    [types.INT_2_10_10_10_REV] = true,
+    [types.UNSIGNED_INT_2_10_10_10_REV] = true,
 }
 
 local BufferLayout = {}
 BufferLayout.__index = BufferLayout
+BufferLayout.types = types
 
 local function validateElements(elements)
     assert(type(elements) == "table" and #elements > 0, "BufferLayout requires at least one element")
@@ -20,26 +44,59 @@ local function validateElements(elements)
     end
 end
 
-local function calculateStride(elements)
-    local stride = 0
+local function elementBytes(element)
+    if packedTypes[element.type] then
+        return 4
+    end
+    return element.size * (typeSizes[element.type] or 4)
+end
+
+-- Attributes start on 4-byte boundaries; many mobile GPUs fetch misaligned
+-- attributes slowly or not at all.
+local function align4(bytes)
+    return (bytes + 3) & ~3
+end
+
+local function assignOffsets(elements)
+    local offset = 0
     for _, element in ipairs(elements) do
-        local bytes = typeSizes[element.type] or 4
-        stride = stride + element.size * bytes
+        element.offset = offset
+        offset = offset + align4(elementBytes(element))
     end
-    return stride
+    return offset
 end
 
 function BufferLayout.new(elements, stride)
     validateElements(elements)
+    local packedStride = assignOffsets(elements)
     local layout = {
         elements = elements,
-        stride = stride or calculateStride(elements),
+        stride = stride or packedStride,
     }
     return setmetatable(layout, BufferLayout)
 end
 
+-- Attribute description consumed by gl.create_packed_vertex_buffer and gl.create_mesh.
+function BufferLayout:packing()
+    if not self.packingCache then
+        local packing = {}
+        for i, element in ipairs(self.elements) do
+            packing[i] = {
+                index = element.index,
+                divisor = element.divisor or 0,
+                type = element.type,
+                size = element.size,
+                normalized = element.normalized or false,
+                offset = element.offset,
+            }
+        end
+        self.packingCache = packing
+    end
+    return self.packingCache
+end
+
 function BufferLayout:apply(offset)
-    local currentOffset = offset or 0
+    local baseOffset = offset or 0
     for _, element in ipairs(self.elements) do
         gl.enable_vertex_attrib_array(element.index)
         gl.vertex_attrib_pointer(
@@ -48,10 +105,11 @@ function BufferLayout:apply(offset)
             element.type,
             element.normalized or false,
             self.stride,
-            currentOffset
+            baseOffset + element.offset
         )
-        local bytes = typeSizes[element.type] or 4
-        currentOffset = currentOffset + element.size * bytes
+        if element.divisor then
+            gl.vertex_attrib_divisor(element.index, element.divisor)
+        end
     end
 end
 
@@ -0,0 +1,116 @@
+local gl = rawget(_G, "opengles") or rawget(_G, "opengl")
+assert(gl, "OpenGL bindings are not available in Lua")
+
+local CommandList = {}
+CommandList.__index = CommandList
+
+local function handleOf(resource)
+    if type(resource) == "table" then
+        return resource.handle or 0
+    end
+    return resource or 0
+end
+
+function CommandList.new()
+    local handle = gl.create_command_list()
+    return setmetatable({ handle = handle }, CommandList)
+end
+
+function CommandList:clear_color(r, g, b, a)
+    gl.cmd_clear_color(self.handle, r, g, b, a)
+    return self
+end
+
+function CommandList:clear(mask)
+    gl.cmd_clear(self.handle, mask)
+    return self
+end
+
+function CommandList:viewport(x, y, width, height)
+    gl.cmd_viewport(self.handle, x, y, width, height)
+    return self
+end
+
+function CommandList:use_shader(shader)
+    gl.cmd_use_shader_program(self.handle, handleOf(shader))
+    return self
+end
+
+function CommandList:bind_vertex_array(vertexArray)
+    gl.cmd_bind_vertex_array(self.handle, handleOf(vertexArray))
+    return self
+end
+
+function CommandList:bind_buffer(buffer, target)
+    gl.cmd_bind_buffer(self.handle, handleOf(buffer), target)
+    return self
+end
+
+function CommandList:set_float(shader, name, value)
+    assert(type(name) == "string", "uniform name must be a string")
+    assert(type(value) == "number", "uniform value must be a number")
+    gl.cmd_set_uniform_float(self.handle, handleOf(shader), name, value)
+    return self
+end
+
+function CommandList:draw_elements(mode, count, indexType, offset)
+    gl.cmd_draw_elements(self.handle, mode, count, indexType, offset or 0)
+    return self
+end
+
+function CommandList:draw_arrays(mode, first, count)
+    gl.cmd_draw_arrays(self.handle, mode, first, count)
+    return self
+end
+
+function CommandList:draw_mesh(mesh, instances, mode)
+    gl.cmd_draw_mesh(self.handle, handleOf(mesh), instances, mode)
+    return self
+end
+
+function CommandList:draw_elements_instanced(mode, count, indexType, offset, instances)
+    gl.cmd_draw_elements_instanced(self.handle, mode, count, indexType, offset or 0, instances)
+    return self
+end
+
+function CommandList:draw_arrays_instanced(mode, first, count, instances)
+    gl.cmd_draw_arrays_instanced(self.handle, mode, first, count, instances)
+    return self
+end
+
+function CommandList:sort()
+    if self.handle then
+        gl.sort_command_list(self.handle)
+    end
+    return self
+end
+
+function CommandList:execute()
+    if self.handle then
+        return gl.execute_command_list(self.handle)
+    end
+    return false
+end
+
+function CommandList:reset()
+    if self.handle then
+        gl.reset_command_list(self.handle)
+    end
+    return self
+end
+
+function CommandList:size()
+    if self.handle then
+        return gl.command_list_size(self.handle)
+    end
+    return 0
+end
+
+function CommandList:delete()
+    if self.handle then
+        gl.delete_command_list(self.handle)
+        self.handle = nil
+    end
+end
+
+return CommandList
@@ -4,14 +4,48 @@ assert(gl, "OpenGL bindings are not available in Lua")
 local IndexBuffer = {}
 IndexBuffer.__index = IndexBuffer
 
+local GL_UNSIGNED_SHORT = 0x1403
+local GL_UNSIGNED_INT = 0x1405
+
 local function ensureTable(data)
     assert(type(data) == "table", "IndexBuffer expects a table of numbers")
 end
 
-function IndexBuffer.new(indices, usage)
+local function narrowestType(indices)
+    local maxIndex = 0
+    for i = 1, #indices do
+        if indices[i] > maxIndex then
+            maxIndex = indices[i]
+        end
+    end
+    return maxIndex <= 0xFFFF and GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+end
+
+local function refreshInfo(buffer)
+    buffer.type, buffer.count = gl.index_buffer_info(buffer.handle)
+end
+
+-- indexType is optional: GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+-- When omitted the narrowest of GL_UNSIGNED_SHORT/GL_UNSIGNED_INT that fits is used.
+function IndexBuffer.new(indices, usage, indexType)
     ensureTable(indices)
-    local handle = gl.create_index_buffer(indices, usage)
-    return setmetatable({ handle = handle }, IndexBuffer)
+    local handle = gl.create_index_buffer(indices, usage, indexType or narrowestType(indices))
+    assert(handle and handle >= 0, "IndexBuffer: indices do not fit the requested index type")
+    local buffer = setmetatable({ handle = handle }, IndexBuffer)
+    refreshInfo(buffer)
+    return buffer
+end
+
+function IndexBuffer:set_data(indices, usage, indexType)
+    ensureTable(indices)
+    if not self.handle then
+        return false
+    end
+    local ok = gl.update_index_buffer(self.handle, indices, usage, indexType)
+    if ok then
+        refreshInfo(self)
+    end
+    return ok
 end
 
 function IndexBuffer:bind()
@@ -0,0 +1,65 @@
+local gl = rawget(_G, "opengles") or rawget(_G, "opengl")
+assert(gl, "OpenGL bindings are not available in Lua")
+
+local Mesh = {}
+Mesh.__index = Mesh
+
+local function ensureTable(data, what)
+    assert(type(data) == "table", "Mesh expects " .. what .. " as a table of numbers")
+end
+
+local function refreshInfo(mesh)
+    mesh.vertex_count, mesh.index_count, mesh.index_type = gl.mesh_info(mesh.handle)
+end
+
+-- layout: a BufferLayout. vertices: every component of vertex 1, then vertex 2, ...
+-- indices is optional. options: { usage = ..., mode = GL_TRIANGLES, index_type = ... }
+function Mesh.new(layout, vertices, indices, options)
+    ensureTable(vertices, "vertices")
+    if indices ~= nil then
+        ensureTable(indices, "indices")
+    end
+    local handle, err = gl.create_mesh(layout:packing(), layout.stride, vertices, indices, options)
+    assert(handle and handle >= 0, "Mesh.new: " .. tostring(err))
+    local mesh = setmetatable({ handle = handle, layout = layout }, Mesh)
+    refreshInfo(mesh)
+    return mesh
+end
+
+function Mesh:set_vertices(vertices)
+    ensureTable(vertices, "vertices")
+    if not self.handle then
+        return false
+    end
+    local ok, err = gl.update_mesh_vertices(self.handle, vertices)
+    assert(ok, "Mesh:set_vertices: " .. tostring(err))
+    refreshInfo(self)
+    return ok
+end
+
+function Mesh:set_indices(indices, indexType)
+    ensureTable(indices, "indices")
+    if not self.handle then
+        return false
+    end
+    local ok, err = gl.update_mesh_indices(self.handle, indices, indexType)
+    assert(ok, "Mesh:set_indices: " .. tostring(err))
+    refreshInfo(self)
+    return ok
+end
+
+function Mesh:draw(instances, mode)
+    if self.handle then
+        return gl.draw_mesh(self.handle, instances, mode)
+    end
+    return false
+end
+
+function Mesh:delete()
+    if self.handle then
+        gl.delete_mesh(self.handle)
+        self.handle = nil
+    end
+end
+
+return Mesh
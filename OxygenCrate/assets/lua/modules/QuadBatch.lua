@@ -0,0 +1,67 @@
+local gl = rawget(_G, "opengles") or rawget(_G, "opengl")
+assert(gl, "OpenGL bindings are not available in Lua")
+
+local QuadBatch = {}
+QuadBatch.__index = QuadBatch
+
+local function handleOf(resource)
+    if type(resource) == "table" then
+        return resource.handle or 0
+    end
+    return resource or 0
+end
+
+-- A native sprite/line batcher. Quads are collected between flushes and drawn
+-- with one call per shader/texture run. Colors are 0xRRGGBBAA numbers or
+-- { r, g, b, a } tables; uv is { u0, v0, u1, v1 }.
+function QuadBatch.new()
+    return setmetatable({ handle = gl.create_quad_batch() }, QuadBatch)
+end
+
+-- Positions become pixels (origin top-left) of a width x height target.
+function QuadBatch:set_viewport(width, height)
+    gl.quad_batch_viewport(self.handle, width, height)
+    return self
+end
+
+-- Applies to the following quads. shader may be a Shader or a handle; 0 keeps
+-- the program bound when flushing. texture is an image/render target/texture id
+-- (0 = white).
+-- Lower layers are drawn first.
+function QuadBatch:set_state(shader, texture, layer)
+    gl.quad_batch_state(self.handle, handleOf(shader), texture or 0, layer or 0)
+    return self
+end
+
+function QuadBatch:quad(x, y, width, height, uv, color)
+    gl.quad_batch_quad(self.handle, x, y, width, height, uv, color)
+    return self
+end
+
+function QuadBatch:line(x0, y0, x1, y1, thickness, color)
+    gl.quad_batch_line(self.handle, x0, y0, x1, y1, thickness, color)
+    return self
+end
+
+function QuadBatch:size()
+    return gl.quad_batch_size(self.handle)
+end
+
+function QuadBatch:clear()
+    gl.quad_batch_clear(self.handle)
+    return self
+end
+
+-- Returns the number of draw calls issued.
+function QuadBatch:flush()
+    return gl.quad_batch_flush(self.handle)
+end
+
+function QuadBatch:delete()
+    if self.handle then
+        gl.delete_quad_batch(self.handle)
+        self.handle = nil
+    end
+end
+
+return QuadBatch
@@ -27,6 +27,38 @@ function Shader.from_files(vertexPath, fragmentPath)
     return Shader.new(vertexSrc, fragmentSrc)
 end
 
+-- Returns immediately; the program compiles in the background. The optional
+-- callback receives (handle, ok, error) once compilation finishes.
+function Shader.new_async(vertexSrc, fragmentSrc, callback)
+    assert(type(vertexSrc) == "string" and vertexSrc ~= "", "vertexSrc must be a string")
+    assert(type(fragmentSrc) == "string" and fragmentSrc ~= "", "fragmentSrc must be a string")
+    local handle = gl.create_shader_program_async(vertexSrc, fragmentSrc, callback)
+    return setmetatable({ handle = handle }, Shader)
+end
+
+function Shader.from_files_async(vertexPath, fragmentPath, callback)
+    local vertexSrc = load_file(vertexPath)
+    local fragmentSrc = load_file(fragmentPath)
+    return Shader.new_async(vertexSrc, fragmentSrc, callback)
+end
+
+function Shader:status()
+    if self.handle then
+        return gl.shader_program_status(self.handle)
+    end
+    return "invalid", ""
+end
+
+function Shader:is_ready()
+    return self:status() == "ready"
+end
+
+function Shader:set_as_fallback()
+    if self.handle then
+        gl.set_fallback_shader_program(self.handle)
+    end
+end
+
 function Shader:use()
     if self.handle then
         gl.use_shader_program(self.handle)
@@ -0,0 +1,47 @@
+local gl = rawget(_G, "opengles") or rawget(_G, "opengl")
+assert(gl, "OpenGL bindings are not available in Lua")
+
+local Texture = {}
+Texture.__index = Texture
+
+-- options: filter ("nearest"/"linear"), min_filter/mag_filter (also the
+-- "*_mipmap_*" names), wrap/wrap_s/wrap_t ("clamp"/"repeat"/"mirror") and
+-- mipmaps. The handle is an image id, so imgui.image and QuadBatch accept it.
+function Texture.new(width, height, pixels, options)
+    local handle = create_texture(width, height, pixels, options)
+    assert(handle and handle >= 0, "Failed to create texture")
+    return setmetatable({ handle = handle, width = width, height = height }, Texture)
+end
+
+-- Loads a KTX file below the module directory. Compressed payloads (ETC2/ASTC
+-- on GLES, BC on desktop) are uploaded as-is; check gl.supports("etc2") etc.
+-- to choose a file. Returns nil and an error message on failure.
+function Texture.load(path, options)
+    local handle, err = load_texture(path, options)
+    if not handle or handle < 0 then
+        return nil, err
+    end
+    local info = texture_info(handle)
+    return setmetatable({ handle = handle, width = info.width, height = info.height }, Texture)
+end
+
+function Texture:set_sampling(options)
+    return set_texture_sampling(self.handle, options)
+end
+
+function Texture:info()
+    return texture_info(self.handle)
+end
+
+function Texture:bind(unit)
+    return gl.bind_texture(self.handle, unit or 0)
+end
+
+function Texture:release()
+    if self.handle then
+        release_texture(self.handle)
+        self.handle = nil
+    end
+end
+
+return Texture
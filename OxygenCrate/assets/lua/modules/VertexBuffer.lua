@@ -14,6 +14,26 @@ function VertexBuffer.new(vertices, usage)
     return setmetatable({ handle = handle }, VertexBuffer)
 end
 
+-- Packs float values into the compact attribute types declared by a
+-- BufferLayout (half floats, normalized bytes, 2_10_10_10, ...). values holds
+-- every component of vertex 1, then vertex 2, in layout order.
+function VertexBuffer.packed(layout, values, usage)
+    ensureTable(values)
+    local handle, err = gl.create_packed_vertex_buffer(values, layout:packing(), layout.stride, usage)
+    assert(handle and handle >= 0, "VertexBuffer.packed: " .. tostring(err))
+    return setmetatable({ handle = handle, layout = layout }, VertexBuffer)
+end
+
+function VertexBuffer:set_packed_data(values, usage, layout)
+    ensureTable(values)
+    layout = layout or self.layout
+    assert(layout, "VertexBuffer:set_packed_data requires a BufferLayout")
+    if self.handle then
+        local ok, err = gl.update_packed_vertex_buffer(self.handle, values, layout:packing(), layout.stride, usage)
+        assert(ok, "VertexBuffer:set_packed_data: " .. tostring(err))
+    end
+end
+
 function VertexBuffer:set_data(vertices, usage)
     ensureTable(vertices)
     if self.handle then
@@ -17,6 +17,8 @@ void ExampleLayer::OnDetach()
 
 void ExampleLayer::OnUpdate(float dt)
 {
+    LuaGLBindings::BeginFrame();
+
     SettingPanel::PanelPreferences pendingPrefs;
     if (m_SettingsPanel.ConsumePendingPreferences(pendingPrefs))
         ApplyPanelPreferences(pendingPrefs);
@@ -33,8 +35,7 @@ void ExampleLayer::OnUpdate(float dt)
 
 void ExampleLayer::CompileLuaScript()
 {
-    const std::string script = m_TextEditorPanel.GetText();
-    m_LuaHost.CompileScript(script);
+    m_LuaHost.CompileScript(m_TextEditorPanel.CreateTextReader());
 }
 
 void ExampleLayer::RequestScriptCompile()
@@ -55,6 +56,7 @@ void ExampleLayer::OnRenderUI()
     if (m_ShowSchedulePanel)
         m_SchedulePanel.Render();
     m_LuaConsole.Render(m_LuaHost);
+    m_GLStats.Render();
 }
 
 void ExampleLayer::RenderControlPanel()
@@ -75,6 +77,14 @@ void ExampleLayer::RenderControlPanel()
         else
             m_LuaConsole.Hide();
     }
+    bool statsVisible = m_GLStats.IsVisible();
+    if (ImGui::Checkbox("GL statistics", &statsVisible))
+    {
+        if (statsVisible)
+            m_GLStats.Show();
+        else
+            m_GLStats.Hide();
+    }
 
     ImGui::SeparatorText("Lua integration");
     if (ImGui::Button("Run script"))
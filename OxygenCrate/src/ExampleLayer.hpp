@@ -5,6 +5,7 @@
 #include "Panels/SettingPanel/SettingPanel.hpp"
 #include "Panels/LuaPanels/LuaScriptHost.hpp"
 #include "Panels/LuaPanels/LuaConsoleWindow.hpp"
+#include "Panels/LuaPanels/GLStatsWindow.hpp"
 #include <imgui.h>
 #include <string>
 
@@ -33,4 +34,5 @@ private:
     SettingPanel m_SettingsPanel;
     LuaScriptHost m_LuaHost;
     LuaConsoleWindow m_LuaConsole;
+    GLStatsWindow m_GLStats;
 };
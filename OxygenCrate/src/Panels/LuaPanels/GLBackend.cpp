@@ -0,0 +1,314 @@
+#include "GLBackend.hpp"
+#include "GLCapabilities.hpp"
+
+namespace {
+
+GLBackend* s_ActiveBackend = nullptr;
+
+// Binds a texture for editing on the active unit and restores whatever was
+// bound there before, since scripts may have their own texture on that unit.
+class ScopedTexture2D
+{
+public:
+    explicit ScopedTexture2D(GLuint id)
+    {
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &m_Previous);
+        glBindTexture(GL_TEXTURE_2D, id);
+    }
+    ~ScopedTexture2D() { glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(m_Previous)); }
+    ScopedTexture2D(const ScopedTexture2D&) = delete;
+    ScopedTexture2D& operator=(const ScopedTexture2D&) = delete;
+
+private:
+    GLint m_Previous = 0;
+};
+
+} // namespace
+
+GLBackend& GLBackend::Get()
+{
+    static OpenGLBackend s_OpenGL;
+    return s_ActiveBackend ? *s_ActiveBackend : s_OpenGL;
+}
+
+void GLBackend::SetActive(GLBackend* backend)
+{
+    s_ActiveBackend = backend;
+}
+
+bool OpenGLBackend::Supports(Feature feature) const
+{
+    switch (feature)
+    {
+    case Feature::Instancing:
+        return GLCapabilities::SupportsInstancing();
+    case Feature::MultiDraw:
+        return GLCapabilities::SupportsMultiDraw();
+    case Feature::IndirectDraw:
+        return GLCapabilities::SupportsIndirectDraw();
+    case Feature::MultiDrawIndirect:
+        return GLCapabilities::SupportsMultiDrawIndirect();
+    case Feature::TimerQuery:
+        if (GLCapabilities::Get().IsES)
+            return GLCapabilities::HasExtension("GL_EXT_disjoint_timer_query");
+        return GLCapabilities::IsAtLeast(3, 3, 0, 0) || GLCapabilities::HasExtension("GL_ARB_timer_query");
+    case Feature::ParallelShaderCompile:
+        return ShaderProgramCache::SupportsParallelCompile();
+    }
+    return false;
+}
+
+GLuint OpenGLBackend::CreateBuffer(GLenum target, std::size_t size, const void* data, GLenum usage)
+{
+    return Flux::GL::CreateBuffer(target, size, data, usage);
+}
+
+GLuint OpenGLBackend::CreateBufferName()
+{
+    GLuint id = 0;
+    glGenBuffers(1, &id);
+    return id;
+}
+
+void OpenGLBackend::UpdateBuffer(GLuint id, GLenum target, std::size_t size, const void* data, GLenum usage)
+{
+    Flux::GL::UpdateBufferData(id, target, size, data, usage);
+}
+
+void OpenGLBackend::CopyIntoBuffer(GLuint id, std::size_t size, const void* data, GLenum usage, bool reallocate)
+{
+    glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+    if (reallocate)
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), data, usage);
+    else if (size > 0)
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void OpenGLBackend::BindBuffer(GLenum target, GLuint id)
+{
+    Flux::GL::BindBuffer(target, id);
+}
+
+GLuint OpenGLBackend::CreateTextureName()
+{
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    return id;
+}
+
+void OpenGLBackend::TexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data)
+{
+    ScopedTexture2D binding(id);
+    glTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(internalFormat), width, height, 0, format, type, data);
+}
+
+void OpenGLBackend::TexSubImage2D(GLuint id, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data)
+{
+    ScopedTexture2D binding(id);
+    glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, format, type, data);
+}
+
+void OpenGLBackend::CompressedTexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei imageSize, const void* data)
+{
+    ScopedTexture2D binding(id);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, imageSize, data);
+}
+
+void OpenGLBackend::SetTextureSampling(GLuint id, GLenum minFilter, GLenum magFilter, GLenum wrapS, GLenum wrapT, GLint maxLevel)
+{
+    ScopedTexture2D binding(id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(minFilter));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(magFilter));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(wrapS));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(wrapT));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+}
+
+void OpenGLBackend::GenerateMipmap(GLuint id)
+{
+    ScopedTexture2D binding(id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+bool OpenGLBackend::SupportsCompressedFormat(GLenum internalFormat) const
+{
+    return GLCapabilities::SupportsCompressedFormat(internalFormat);
+}
+
+void OpenGLBackend::BindTexture(GLuint unit, GLenum target, GLuint id)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, id);
+}
+
+GLuint OpenGLBackend::CreateVertexArray()
+{
+    return Flux::GL::CreateVertexArray();
+}
+
+void OpenGLBackend::BindVertexArray(GLuint id)
+{
+    Flux::GL::BindVertexArray(id);
+}
+
+void OpenGLBackend::EnableVertexAttribArray(GLuint index)
+{
+    Flux::GL::EnableVertexAttribArray(index);
+}
+
+void OpenGLBackend::VertexAttribPointer(GLuint index, GLint size, GLenum type, bool normalized, GLsizei stride, intptr_t offset)
+{
+    Flux::GL::VertexAttribPointer(index, size, type, normalized, stride, offset);
+}
+
+void OpenGLBackend::VertexAttribDivisor(GLuint index, GLuint divisor)
+{
+    glVertexAttribDivisor(index, divisor);
+}
+
+GLuint OpenGLBackend::CreateProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error)
+{
+    return ShaderProgramCache::CreateProgram(vertexSrc, fragmentSrc, error);
+}
+
+ShaderProgramCache::PendingProgram OpenGLBackend::BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc)
+{
+    return ShaderProgramCache::BeginProgram(vertexSrc, fragmentSrc);
+}
+
+ShaderProgramCache::ProgramStatus OpenGLBackend::PollProgram(ShaderProgramCache::PendingProgram& pending, bool allowBlocking, std::string& error)
+{
+    return ShaderProgramCache::PollProgram(pending, allowBlocking, error);
+}
+
+void OpenGLBackend::CancelProgram(ShaderProgramCache::PendingProgram& pending)
+{
+    ShaderProgramCache::CancelProgram(pending);
+}
+
+void OpenGLBackend::UseProgram(GLuint program)
+{
+    Flux::GL::UseProgram(program);
+}
+
+GLint OpenGLBackend::GetUniformLocation(GLuint program, const char* name)
+{
+    return glGetUniformLocation(program, name);
+}
+
+void OpenGLBackend::Uniform1f(GLint location, float value)
+{
+    glUniform1f(location, value);
+}
+
+bool OpenGLBackend::SetUniformFloat(GLuint program, const char* name, float value)
+{
+    return Flux::GL::SetUniformFloat(program, name, value);
+}
+
+void OpenGLBackend::ClearColor(float r, float g, float b, float a)
+{
+    Flux::GL::ClearColor(r, g, b, a);
+}
+
+void OpenGLBackend::Clear(GLbitfield mask)
+{
+    Flux::GL::Clear(mask);
+}
+
+void OpenGLBackend::Viewport(int x, int y, int width, int height)
+{
+    Flux::GL::Viewport(x, y, width, height);
+}
+
+void OpenGLBackend::DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glDrawArrays(mode, first, count);
+}
+
+void OpenGLBackend::DrawElements(GLenum mode, GLsizei count, GLenum type, intptr_t offset)
+{
+    Flux::GL::DrawElements(mode, count, type, offset);
+}
+
+void OpenGLBackend::DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    glDrawArraysInstanced(mode, first, count, instances);
+}
+
+void OpenGLBackend::DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, intptr_t offset, GLsizei instances)
+{
+    glDrawElementsInstanced(mode, count, type, reinterpret_cast<const void*>(offset), instances);
+}
+
+void OpenGLBackend::MultiDrawArrays(GLenum mode, const GLint* firsts, const GLsizei* counts, GLsizei drawCount)
+{
+#if !defined(__ANDROID__)
+    glMultiDrawArrays(mode, firsts, counts, drawCount);
+#else
+    for (GLsizei i = 0; i < drawCount; ++i)
+        glDrawArrays(mode, firsts[i], counts[i]);
+#endif
+}
+
+void OpenGLBackend::MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount)
+{
+#if !defined(__ANDROID__)
+    glMultiDrawElements(mode, counts, type, indices, drawCount);
+#else
+    for (GLsizei i = 0; i < drawCount; ++i)
+        glDrawElements(mode, counts[i], type, indices[i]);
+#endif
+}
+
+void OpenGLBackend::DrawArraysIndirect(GLenum mode, const void* indirect)
+{
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+    glDrawArraysIndirect(mode, indirect);
+#else
+    (void)mode;
+    (void)indirect;
+#endif
+}
+
+void OpenGLBackend::DrawElementsIndirect(GLenum mode, GLenum type, const void* indirect)
+{
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+    glDrawElementsIndirect(mode, type, indirect);
+#else
+    (void)mode;
+    (void)type;
+    (void)indirect;
+#endif
+}
+
+void OpenGLBackend::MultiDrawArraysIndirect(GLenum mode, const void* indirect, GLsizei drawCount, GLsizei stride)
+{
+#if !defined(__ANDROID__) && defined(GL_DRAW_INDIRECT_BUFFER)
+    glMultiDrawArraysIndirect(mode, indirect, drawCount, stride);
+#else
+    (void)mode;
+    (void)indirect;
+    (void)drawCount;
+    (void)stride;
+#endif
+}
+
+void OpenGLBackend::MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride)
+{
+#if !defined(__ANDROID__) && defined(GL_DRAW_INDIRECT_BUFFER)
+    glMultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+#else
+    (void)mode;
+    (void)type;
+    (void)indirect;
+    (void)drawCount;
+    (void)stride;
+#endif
+}
+
+void OpenGLBackend::DeleteObject(GLDeletionQueue::ObjectType type, GLuint id)
+{
+    GLDeletionQueue::Enqueue(type, id);
+}
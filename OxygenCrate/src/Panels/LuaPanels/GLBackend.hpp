@@ -0,0 +1,152 @@
+#pragma once
+
+#include "GLDeletionQueue.hpp"
+#include "GLWrappers.hpp"
+#include "ShaderProgramCache.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The GL calls made by the Lua bindings. The default backend forwards to the
+// current context; a headless backend (see RecordingGLBackend) lets the
+// bindings run without one.
+class GLBackend
+{
+public:
+    enum class Feature
+    {
+        Instancing,
+        MultiDraw,
+        IndirectDraw,
+        MultiDrawIndirect,
+        TimerQuery,
+        ParallelShaderCompile
+    };
+
+    virtual ~GLBackend() = default;
+
+    // The backend the bindings use. Falls back to the OpenGL backend when no
+    // other backend has been installed.
+    static GLBackend& Get();
+    // Installs a backend (nullptr restores OpenGL). The caller keeps ownership
+    // and must release every script resource before switching.
+    static void SetActive(GLBackend* backend);
+
+    virtual const char* GetName() const = 0;
+    // True when no GL context is behind the backend.
+    virtual bool IsHeadless() const = 0;
+    virtual bool Supports(Feature feature) const = 0;
+
+    virtual GLuint CreateBuffer(GLenum target, std::size_t size, const void* data, GLenum usage) = 0;
+    // Reserves a buffer name without binding it or allocating storage.
+    virtual GLuint CreateBufferName() = 0;
+    virtual void UpdateBuffer(GLuint id, GLenum target, std::size_t size, const void* data, GLenum usage) = 0;
+    // Uploads through GL_COPY_WRITE_BUFFER so no VAO or element binding changes.
+    // Reallocates the storage when reallocate is set, otherwise overwrites it.
+    virtual void CopyIntoBuffer(GLuint id, std::size_t size, const void* data, GLenum usage, bool reallocate) = 0;
+    virtual void BindBuffer(GLenum target, GLuint id) = 0;
+
+    // 2D textures. Uploads and parameter changes bind the texture on the active
+    // unit and restore the previous GL_TEXTURE_2D binding afterwards.
+    virtual GLuint CreateTextureName() = 0;
+    virtual void TexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) = 0;
+    virtual void TexSubImage2D(GLuint id, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) = 0;
+    virtual void CompressedTexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei imageSize, const void* data) = 0;
+    // maxLevel limits sampling to the levels that were uploaded.
+    virtual void SetTextureSampling(GLuint id, GLenum minFilter, GLenum magFilter, GLenum wrapS, GLenum wrapT, GLint maxLevel) = 0;
+    virtual void GenerateMipmap(GLuint id) = 0;
+    virtual bool SupportsCompressedFormat(GLenum internalFormat) const = 0;
+    virtual void BindTexture(GLuint unit, GLenum target, GLuint id) = 0;
+
+    virtual GLuint CreateVertexArray() = 0;
+    virtual void BindVertexArray(GLuint id) = 0;
+    virtual void EnableVertexAttribArray(GLuint index) = 0;
+    virtual void VertexAttribPointer(GLuint index, GLint size, GLenum type, bool normalized, GLsizei stride, intptr_t offset) = 0;
+    virtual void VertexAttribDivisor(GLuint index, GLuint divisor) = 0;
+
+    virtual GLuint CreateProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error) = 0;
+    virtual ShaderProgramCache::PendingProgram BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc) = 0;
+    virtual ShaderProgramCache::ProgramStatus PollProgram(ShaderProgramCache::PendingProgram& pending, bool allowBlocking, std::string& error) = 0;
+    virtual void CancelProgram(ShaderProgramCache::PendingProgram& pending) = 0;
+    virtual void UseProgram(GLuint program) = 0;
+    virtual GLint GetUniformLocation(GLuint program, const char* name) = 0;
+    virtual void Uniform1f(GLint location, float value) = 0;
+    virtual bool SetUniformFloat(GLuint program, const char* name, float value) = 0;
+
+    virtual void ClearColor(float r, float g, float b, float a) = 0;
+    virtual void Clear(GLbitfield mask) = 0;
+    virtual void Viewport(int x, int y, int width, int height) = 0;
+
+    virtual void DrawArrays(GLenum mode, GLint first, GLsizei count) = 0;
+    virtual void DrawElements(GLenum mode, GLsizei count, GLenum type, intptr_t offset) = 0;
+    virtual void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) = 0;
+    virtual void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, intptr_t offset, GLsizei instances) = 0;
+    // Multi-draw and indirect entry points are only called when the matching
+    // feature is supported.
+    virtual void MultiDrawArrays(GLenum mode, const GLint* firsts, const GLsizei* counts, GLsizei drawCount) = 0;
+    virtual void MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount) = 0;
+    virtual void DrawArraysIndirect(GLenum mode, const void* indirect) = 0;
+    virtual void DrawElementsIndirect(GLenum mode, GLenum type, const void* indirect) = 0;
+    virtual void MultiDrawArraysIndirect(GLenum mode, const void* indirect, GLsizei drawCount, GLsizei stride) = 0;
+    virtual void MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) = 0;
+
+    // Releases an object created through this backend. The OpenGL backend
+    // defers the deletion through GLDeletionQueue.
+    virtual void DeleteObject(GLDeletionQueue::ObjectType type, GLuint id) = 0;
+};
+
+// Forwards every call to the current GL context.
+class OpenGLBackend final : public GLBackend
+{
+public:
+    const char* GetName() const override { return "opengl"; }
+    bool IsHeadless() const override { return false; }
+    bool Supports(Feature feature) const override;
+
+    GLuint CreateBuffer(GLenum target, std::size_t size, const void* data, GLenum usage) override;
+    GLuint CreateBufferName() override;
+    void UpdateBuffer(GLuint id, GLenum target, std::size_t size, const void* data, GLenum usage) override;
+    void CopyIntoBuffer(GLuint id, std::size_t size, const void* data, GLenum usage, bool reallocate) override;
+    void BindBuffer(GLenum target, GLuint id) override;
+
+    GLuint CreateTextureName() override;
+    void TexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) override;
+    void TexSubImage2D(GLuint id, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) override;
+    void CompressedTexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei imageSize, const void* data) override;
+    void SetTextureSampling(GLuint id, GLenum minFilter, GLenum magFilter, GLenum wrapS, GLenum wrapT, GLint maxLevel) override;
+    void GenerateMipmap(GLuint id) override;
+    bool SupportsCompressedFormat(GLenum internalFormat) const override;
+    void BindTexture(GLuint unit, GLenum target, GLuint id) override;
+
+    GLuint CreateVertexArray() override;
+    void BindVertexArray(GLuint id) override;
+    void EnableVertexAttribArray(GLuint index) override;
+    void VertexAttribPointer(GLuint index, GLint size, GLenum type, bool normalized, GLsizei stride, intptr_t offset) override;
+    void VertexAttribDivisor(GLuint index, GLuint divisor) override;
+
+    GLuint CreateProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error) override;
+    ShaderProgramCache::PendingProgram BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc) override;
+    ShaderProgramCache::ProgramStatus PollProgram(ShaderProgramCache::PendingProgram& pending, bool allowBlocking, std::string& error) override;
+    void CancelProgram(ShaderProgramCache::PendingProgram& pending) override;
+    void UseProgram(GLuint program) override;
+    GLint GetUniformLocation(GLuint program, const char* name) override;
+    void Uniform1f(GLint location, float value) override;
+    bool SetUniformFloat(GLuint program, const char* name, float value) override;
+
+    void ClearColor(float r, float g, float b, float a) override;
+    void Clear(GLbitfield mask) override;
+    void Viewport(int x, int y, int width, int height) override;
+
+    void DrawArrays(GLenum mode, GLint first, GLsizei count) override;
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, intptr_t offset) override;
+    void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) override;
+    void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, intptr_t offset, GLsizei instances) override;
+    void MultiDrawArrays(GLenum mode, const GLint* firsts, const GLsizei* counts, GLsizei drawCount) override;
+    void MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount) override;
+    void DrawArraysIndirect(GLenum mode, const void* indirect) override;
+    void DrawElementsIndirect(GLenum mode, GLenum type, const void* indirect) override;
+    void MultiDrawArraysIndirect(GLenum mode, const void* indirect, GLsizei drawCount, GLsizei stride) override;
+    void MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) override;
+
+    void DeleteObject(GLDeletionQueue::ObjectType type, GLuint id) override;
+};
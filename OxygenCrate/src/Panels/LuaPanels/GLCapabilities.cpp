@@ -0,0 +1,111 @@
+#include "GLCapabilities.hpp"
+#include "GLWrappers.hpp"
+
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct CapabilityCache {
+    bool Queried = false;
+    GLCapabilities::Info Info;
+    std::unordered_set<std::string> Extensions;
+    std::unordered_set<GLenum> CompressedFormats;
+};
+
+CapabilityCache& GetCache() {
+    static CapabilityCache s_Cache;
+    if (s_Cache.Queried)
+        return s_Cache;
+
+    s_Cache.Queried = true;
+    auto readString = [](GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string{};
+    };
+    s_Cache.Info.Vendor = readString(GL_VENDOR);
+    s_Cache.Info.Renderer = readString(GL_RENDERER);
+    s_Cache.Info.Version = readString(GL_VERSION);
+    s_Cache.Info.IsES = s_Cache.Info.Version.rfind("OpenGL ES", 0) == 0;
+
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    s_Cache.Info.Major = major;
+    s_Cache.Info.Minor = minor;
+
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; ++i) {
+        const GLubyte* name = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+        if (name)
+            s_Cache.Extensions.insert(reinterpret_cast<const char*>(name));
+    }
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+    if (formatCount > 0) {
+        std::vector<GLint> formats(static_cast<std::size_t>(formatCount));
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        for (GLint format : formats)
+            s_Cache.CompressedFormats.insert(static_cast<GLenum>(format));
+    }
+    return s_Cache;
+}
+
+} // namespace
+
+namespace GLCapabilities {
+
+const Info& Get() {
+    return GetCache().Info;
+}
+
+bool HasExtension(const char* name) {
+    return name && GetCache().Extensions.count(name) != 0;
+}
+
+bool IsAtLeast(int desktopMajor, int desktopMinor, int esMajor, int esMinor) {
+    const Info& info = Get();
+    const int major = info.IsES ? esMajor : desktopMajor;
+    const int minor = info.IsES ? esMinor : desktopMinor;
+    return info.Major > major || (info.Major == major && info.Minor >= minor);
+}
+
+bool SupportsInstancing() {
+    return IsAtLeast(3, 3, 3, 0);
+}
+
+bool SupportsMultiDraw() {
+#if defined(__ANDROID__)
+    return false;
+#else
+    return !Get().IsES;
+#endif
+}
+
+bool SupportsIndirectDraw() {
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+    return IsAtLeast(4, 0, 3, 1);
+#else
+    return false;
+#endif
+}
+
+bool SupportsMultiDrawIndirect() {
+#if !defined(__ANDROID__) && defined(GL_DRAW_INDIRECT_BUFFER)
+    if (Get().IsES)
+        return false;
+    return IsAtLeast(4, 3, 0, 0) || HasExtension("GL_ARB_multi_draw_indirect");
+#else
+    return false;
+#endif
+}
+
+bool SupportsCompressedFormat(unsigned int internalFormat) {
+    return GetCache().CompressedFormats.count(internalFormat) != 0;
+}
+
+} // namespace GLCapabilities
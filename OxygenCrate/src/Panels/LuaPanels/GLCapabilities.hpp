@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+// Queries the current GL context once and answers feature questions for the
+// Lua bindings. Must only be called while the render context is current.
+namespace GLCapabilities {
+
+struct Info {
+    bool IsES = false;
+    int Major = 0;
+    int Minor = 0;
+    std::string Vendor;
+    std::string Renderer;
+    std::string Version;
+};
+
+const Info& Get();
+bool HasExtension(const char* name);
+// True when the context is at least desktop GL desktopMajor.desktopMinor or
+// GLES esMajor.esMinor, depending on which API is running.
+bool IsAtLeast(int desktopMajor, int desktopMinor, int esMajor, int esMinor);
+
+bool SupportsInstancing();
+bool SupportsMultiDraw();
+bool SupportsIndirectDraw();
+bool SupportsMultiDrawIndirect();
+// True when the format is listed in GL_COMPRESSED_TEXTURE_FORMATS.
+bool SupportsCompressedFormat(unsigned int internalFormat);
+
+} // namespace GLCapabilities
@@ -0,0 +1,119 @@
+#include "GLDeletionQueue.hpp"
+
+#include <array>
+#include <deque>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kObjectTypeCount = 6;
+// Fences should signal within a couple of frames. If they pile up anyway
+// (e.g. a driver that never signals), the oldest batch is deleted regardless.
+constexpr std::size_t kMaxPendingBatches = 8;
+
+struct Batch {
+    std::array<std::vector<GLuint>, kObjectTypeCount> objects;
+    GLsync fence = nullptr;
+
+    bool Empty() const {
+        for (const auto& ids : objects) {
+            if (!ids.empty())
+                return false;
+        }
+        return true;
+    }
+
+    std::size_t Size() const {
+        std::size_t size = 0;
+        for (const auto& ids : objects)
+            size += ids.size();
+        return size;
+    }
+};
+
+Batch s_Current;
+std::deque<Batch> s_Pending;
+
+void DeleteObjects(GLDeletionQueue::ObjectType type, const std::vector<GLuint>& ids) {
+    if (ids.empty())
+        return;
+    const GLsizei count = static_cast<GLsizei>(ids.size());
+    switch (type) {
+    case GLDeletionQueue::ObjectType::Buffer:
+        glDeleteBuffers(count, ids.data());
+        break;
+    case GLDeletionQueue::ObjectType::VertexArray:
+        glDeleteVertexArrays(count, ids.data());
+        break;
+    case GLDeletionQueue::ObjectType::Program:
+        for (GLuint id : ids)
+            glDeleteProgram(id);
+        break;
+    case GLDeletionQueue::ObjectType::Texture:
+        glDeleteTextures(count, ids.data());
+        break;
+    case GLDeletionQueue::ObjectType::Renderbuffer:
+        glDeleteRenderbuffers(count, ids.data());
+        break;
+    case GLDeletionQueue::ObjectType::Framebuffer:
+        glDeleteFramebuffers(count, ids.data());
+        break;
+    }
+}
+
+void Retire(Batch& batch) {
+    for (std::size_t type = 0; type < kObjectTypeCount; ++type)
+        DeleteObjects(static_cast<GLDeletionQueue::ObjectType>(type), batch.objects[type]);
+    if (batch.fence != nullptr)
+        glDeleteSync(batch.fence);
+    batch = Batch{};
+}
+
+bool IsSignalled(GLsync fence) {
+    if (fence == nullptr)
+        return true;
+    const GLenum result = glClientWaitSync(fence, 0, 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+} // namespace
+
+namespace GLDeletionQueue {
+
+void Enqueue(ObjectType type, GLuint id) {
+    if (id != 0)
+        s_Current.objects[static_cast<std::size_t>(type)].push_back(id);
+}
+
+void BeginFrame() {
+    if (!s_Current.Empty()) {
+        s_Current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        s_Pending.push_back(std::move(s_Current));
+        s_Current = Batch{};
+    }
+
+    while (!s_Pending.empty() && (IsSignalled(s_Pending.front().fence) || s_Pending.size() > kMaxPendingBatches)) {
+        Retire(s_Pending.front());
+        s_Pending.pop_front();
+    }
+}
+
+void Flush() {
+    for (Batch& batch : s_Pending)
+        Retire(batch);
+    s_Pending.clear();
+    Retire(s_Current);
+}
+
+std::size_t GetPendingObjectCount() {
+    std::size_t count = s_Current.Size();
+    for (const Batch& batch : s_Pending)
+        count += batch.Size();
+    return count;
+}
+
+std::size_t GetPendingBatchCount() {
+    return s_Pending.size() + (s_Current.Empty() ? 0 : 1);
+}
+
+} // namespace GLDeletionQueue
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+#include <cstddef>
+
+// Defers deletion of GL objects until the GPU has finished the frames that
+// may still reference them. Deletions requested during a frame are collected
+// into a batch; BeginFrame closes the batch behind a fence and deletes, in
+// bulk, every earlier batch whose fence has signalled.
+namespace GLDeletionQueue {
+
+enum class ObjectType {
+    Buffer,
+    VertexArray,
+    Program,
+    Texture,
+    Renderbuffer,
+    Framebuffer
+};
+
+void Enqueue(ObjectType type, GLuint id);
+// Call once per frame, before any script rendering.
+void BeginFrame();
+// Deletes everything immediately. Used at shutdown.
+void Flush();
+
+// Objects waiting for deletion, including the batch of the current frame.
+std::size_t GetPendingObjectCount();
+std::size_t GetPendingBatchCount();
+
+} // namespace GLDeletionQueue
@@ -0,0 +1,44 @@
+#include "GLFrameStats.hpp"
+
+#include <array>
+
+namespace {
+
+GLFrameStats::Counters s_Current;
+std::array<GLFrameStats::Counters, GLFrameStats::kHistoryLength> s_History;
+std::size_t s_HistoryStart = 0;
+std::size_t s_HistorySize = 0;
+
+} // namespace
+
+namespace GLFrameStats {
+
+Counters& Current() {
+    return s_Current;
+}
+
+const Counters& LastFrame() {
+    static const Counters s_Empty;
+    return s_HistorySize == 0 ? s_Empty : GetHistory(s_HistorySize - 1);
+}
+
+void BeginFrame() {
+    if (s_HistorySize < kHistoryLength) {
+        s_History[(s_HistoryStart + s_HistorySize) % kHistoryLength] = s_Current;
+        ++s_HistorySize;
+    } else {
+        s_History[s_HistoryStart] = s_Current;
+        s_HistoryStart = (s_HistoryStart + 1) % kHistoryLength;
+    }
+    s_Current = Counters{};
+}
+
+std::size_t GetHistorySize() {
+    return s_HistorySize;
+}
+
+const Counters& GetHistory(std::size_t index) {
+    return s_History[(s_HistoryStart + index) % kHistoryLength];
+}
+
+} // namespace GLFrameStats
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-frame counters for GL work issued on behalf of Lua scripts. The current
+// frame accumulates until BeginFrame, which moves it into a rolling history.
+namespace GLFrameStats {
+
+struct Counters {
+    // Draws, not API calls: a multi-draw of N entries counts N.
+    uint32_t DrawCalls = 0;
+    uint32_t Clears = 0;
+    uint32_t ShaderBinds = 0;
+    uint32_t VertexArrayBinds = 0;
+    uint32_t BufferBinds = 0;
+    uint32_t FramebufferBinds = 0;
+    uint32_t TextureBinds = 0;
+    uint32_t UniformUpdates = 0;
+    uint32_t BufferUploads = 0;
+    uint64_t BufferBytes = 0;
+    uint32_t TextureUploads = 0;
+    uint64_t TextureBytes = 0;
+    uint32_t Readbacks = 0;
+    uint64_t ReadbackBytes = 0;
+
+    uint32_t StateChanges() const {
+        return ShaderBinds + VertexArrayBinds + BufferBinds + FramebufferBinds + TextureBinds + UniformUpdates;
+    }
+};
+
+constexpr std::size_t kHistoryLength = 240;
+
+Counters& Current();
+// Totals of the last completed frame.
+const Counters& LastFrame();
+void BeginFrame();
+
+// Completed frames, oldest first; at most kHistoryLength entries.
+std::size_t GetHistorySize();
+const Counters& GetHistory(std::size_t index);
+
+} // namespace GLFrameStats
@@ -0,0 +1,116 @@
+#include "GLStatsWindow.hpp"
+#include "GLFrameStats.hpp"
+#include "GLTimerQueries.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+template <typename Getter>
+void PlotHistory(const char* label, std::vector<float>& values, Getter getter)
+{
+    const std::size_t count = GLFrameStats::GetHistorySize();
+    values.resize(count);
+    float maxValue = 1.0f;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        values[i] = static_cast<float>(getter(GLFrameStats::GetHistory(i)));
+        maxValue = std::max(maxValue, values[i]);
+    }
+
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "max %.0f", maxValue);
+    ImGui::PlotLines(label, values.data(), static_cast<int>(values.size()), 0, overlay,
+        0.0f, maxValue * 1.1f, ImVec2(0.0f, 48.0f));
+}
+
+void CounterRow(const char* name, unsigned long long value)
+{
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", value);
+}
+
+void RenderTimers()
+{
+    if (!GLTimerQueries::IsAvailable())
+        ImGui::TextDisabled("GPU timer queries are unavailable on this context; showing CPU time only.");
+
+    if (GLTimerQueries::GetScopeCount() == 0)
+    {
+        ImGui::TextDisabled("No timers. Wrap passes in begin_timer(name) / end_timer().");
+        return;
+    }
+
+    if (ImGui::BeginTable("GLStatsTimers", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+        for (std::size_t i = 0; i < GLTimerQueries::GetScopeCount(); ++i)
+        {
+            const GLTimerQueries::Scope& scope = GLTimerQueries::GetScope(i);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(scope.Name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", scope.CpuMs);
+            ImGui::TableNextColumn();
+            if (scope.HasGpuResult)
+                ImGui::Text("%.3f", scope.GpuMs);
+            else
+                ImGui::TextDisabled("-");
+        }
+        ImGui::EndTable();
+    }
+}
+
+} // namespace
+
+void GLStatsWindow::Render()
+{
+    if (!m_IsVisible)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(360.0f, 420.0f), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("GL Statistics", &m_IsVisible))
+    {
+        const GLFrameStats::Counters& stats = GLFrameStats::LastFrame();
+        if (ImGui::BeginTable("GLStatsCounters", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+        {
+            ImGui::TableSetupColumn("Counter");
+            ImGui::TableSetupColumn("Last frame");
+            ImGui::TableHeadersRow();
+            CounterRow("Draw calls", stats.DrawCalls);
+            CounterRow("Clears", stats.Clears);
+            CounterRow("State changes", stats.StateChanges());
+            CounterRow("  Shader binds", stats.ShaderBinds);
+            CounterRow("  Vertex array binds", stats.VertexArrayBinds);
+            CounterRow("  Buffer binds", stats.BufferBinds);
+            CounterRow("  Framebuffer binds", stats.FramebufferBinds);
+            CounterRow("  Texture binds", stats.TextureBinds);
+            CounterRow("  Uniform updates", stats.UniformUpdates);
+            CounterRow("Buffer uploads", stats.BufferUploads);
+            CounterRow("Buffer bytes", stats.BufferBytes);
+            CounterRow("Texture uploads", stats.TextureUploads);
+            CounterRow("Texture bytes", stats.TextureBytes);
+            CounterRow("Readbacks", stats.Readbacks);
+            CounterRow("Readback bytes", stats.ReadbackBytes);
+            ImGui::EndTable();
+        }
+
+        ImGui::SeparatorText("Timers");
+        RenderTimers();
+
+        ImGui::SeparatorText("History");
+        PlotHistory("Draw calls", m_PlotValues, [](const GLFrameStats::Counters& frame) { return frame.DrawCalls; });
+        PlotHistory("State changes", m_PlotValues, [](const GLFrameStats::Counters& frame) { return frame.StateChanges(); });
+        PlotHistory("Upload KiB", m_PlotValues, [](const GLFrameStats::Counters& frame) {
+            return (frame.BufferBytes + frame.TextureBytes) / 1024;
+        });
+    }
+    ImGui::End();
+}
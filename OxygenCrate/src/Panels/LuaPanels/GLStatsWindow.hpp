@@ -0,0 +1,18 @@
+#pragma once
+
+#include <imgui.h>
+#include <vector>
+
+class GLStatsWindow {
+public:
+    bool IsVisible() const { return m_IsVisible; }
+    void Toggle() { m_IsVisible = !m_IsVisible; }
+    void Show() { m_IsVisible = true; }
+    void Hide() { m_IsVisible = false; }
+
+    void Render();
+
+private:
+    bool m_IsVisible = false;
+    std::vector<float> m_PlotValues;
+};
@@ -0,0 +1,208 @@
+#include "GLTimerQueries.hpp"
+#include "GLBackend.hpp"
+#include "GLCapabilities.hpp"
+#include "GLWrappers.hpp"
+
+#include <chrono>
+#include <vector>
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMaxPendingQueries = 64;
+constexpr std::size_t kMaxFreeQueries = 16;
+constexpr double kSmoothing = 0.1;
+
+struct PendingQuery {
+    GLuint Query = 0;
+    std::size_t ScopeIndex = 0;
+};
+
+struct OpenScope {
+    bool Active = false;
+    std::size_t ScopeIndex = 0;
+    GLuint Query = 0;
+    Clock::time_point Start;
+};
+
+std::vector<GLTimerQueries::Scope> s_Scopes;
+std::vector<PendingQuery> s_Pending;
+std::vector<GLuint> s_FreeQueries;
+OpenScope s_Open;
+
+GLenum TimeElapsedTarget() {
+#if defined(__ANDROID__)
+    return GL_TIME_ELAPSED_EXT;
+#else
+    return GL_TIME_ELAPSED;
+#endif
+}
+
+double Smooth(double current, double sample, bool first) {
+    return first ? sample : current + (sample - current) * kSmoothing;
+}
+
+std::size_t FindOrAddScope(const std::string& name) {
+    for (std::size_t i = 0; i < s_Scopes.size(); ++i) {
+        if (s_Scopes[i].Name == name)
+            return i;
+    }
+    GLTimerQueries::Scope scope;
+    scope.Name = name;
+    s_Scopes.push_back(scope);
+    return s_Scopes.size() - 1;
+}
+
+GLuint AcquireQuery() {
+    if (!s_FreeQueries.empty()) {
+        GLuint query = s_FreeQueries.back();
+        s_FreeQueries.pop_back();
+        return query;
+    }
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    return query;
+}
+
+void RecycleQuery(GLuint query) {
+    if (s_FreeQueries.size() < kMaxFreeQueries)
+        s_FreeQueries.push_back(query);
+    else
+        glDeleteQueries(1, &query);
+}
+
+uint64_t ReadQueryNanoseconds(GLuint query) {
+#if defined(__ANDROID__)
+    // The 32-bit result is core in GLES 3.0 and covers about four seconds,
+    // which avoids loading glGetQueryObjectui64vEXT at runtime.
+    GLuint elapsed = 0;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &elapsed);
+    return elapsed;
+#else
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+    return static_cast<uint64_t>(elapsed);
+#endif
+}
+
+bool ConsumeDisjoint() {
+    if (!GLCapabilities::Get().IsES)
+        return false;
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return disjoint != 0;
+}
+
+} // namespace
+
+namespace GLTimerQueries {
+
+bool IsAvailable() {
+    return GLBackend::Get().Supports(GLBackend::Feature::TimerQuery);
+}
+
+bool Begin(const std::string& name, std::string& error) {
+    if (s_Open.Active) {
+        error = "timer '" + s_Scopes[s_Open.ScopeIndex].Name + "' is still open; GPU timers cannot nest";
+        return false;
+    }
+
+    s_Open.Active = true;
+    s_Open.ScopeIndex = FindOrAddScope(name);
+    s_Open.Query = 0;
+    if (IsAvailable() && s_Pending.size() < kMaxPendingQueries) {
+        s_Open.Query = AcquireQuery();
+        glBeginQuery(TimeElapsedTarget(), s_Open.Query);
+    }
+    s_Open.Start = Clock::now();
+    return true;
+}
+
+bool End(std::string& error) {
+    if (!s_Open.Active) {
+        error = "no timer is open";
+        return false;
+    }
+
+    const double cpuMs = std::chrono::duration<double, std::milli>(Clock::now() - s_Open.Start).count();
+    Scope& scope = s_Scopes[s_Open.ScopeIndex];
+    scope.CpuMs = Smooth(scope.CpuMs, cpuMs, scope.Samples == 0);
+    ++scope.Samples;
+    if (s_Open.Query != 0) {
+        glEndQuery(TimeElapsedTarget());
+        s_Pending.push_back(PendingQuery{ s_Open.Query, s_Open.ScopeIndex });
+    }
+    s_Open = OpenScope{};
+    return true;
+}
+
+void BeginFrame() {
+    if (s_Open.Active) {
+        std::string ignored;
+        End(ignored);
+    }
+    if (s_Pending.empty())
+        return;
+
+    // A disjoint event invalidates every query that was in flight.
+    const bool disjoint = ConsumeDisjoint();
+    std::size_t retired = 0;
+    for (; retired < s_Pending.size(); ++retired) {
+        const PendingQuery& pending = s_Pending[retired];
+        GLuint available = 0;
+        glGetQueryObjectuiv(pending.Query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        if (!disjoint) {
+            const double gpuMs = static_cast<double>(ReadQueryNanoseconds(pending.Query)) / 1.0e6;
+            Scope& scope = s_Scopes[pending.ScopeIndex];
+            scope.GpuMs = Smooth(scope.GpuMs, gpuMs, !scope.HasGpuResult);
+            scope.HasGpuResult = true;
+        }
+        RecycleQuery(pending.Query);
+    }
+    s_Pending.erase(s_Pending.begin(), s_Pending.begin() + static_cast<std::ptrdiff_t>(retired));
+}
+
+void Reset() {
+    if (s_Open.Active && s_Open.Query != 0)
+        glEndQuery(TimeElapsedTarget());
+    s_Open = OpenScope{};
+    for (const PendingQuery& pending : s_Pending)
+        glDeleteQueries(1, &pending.Query);
+    s_Pending.clear();
+    if (!s_FreeQueries.empty())
+        glDeleteQueries(static_cast<GLsizei>(s_FreeQueries.size()), s_FreeQueries.data());
+    s_FreeQueries.clear();
+    s_Scopes.clear();
+}
+
+std::size_t GetScopeCount() {
+    return s_Scopes.size();
+}
+
+const Scope& GetScope(std::size_t index) {
+    return s_Scopes[index];
+}
+
+const Scope* FindScope(const std::string& name) {
+    for (const Scope& scope : s_Scopes) {
+        if (scope.Name == name)
+            return &scope;
+    }
+    return nullptr;
+}
+
+std::size_t GetPendingQueryCount() {
+    return s_Pending.size();
+}
+
+} // namespace GLTimerQueries
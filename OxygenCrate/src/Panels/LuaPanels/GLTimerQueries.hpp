@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Named GPU timer scopes built on GL_TIME_ELAPSED queries (EXT_disjoint_timer_query
+// on GLES). Results are polled without blocking at the start of each frame and
+// usually arrive a few frames after the scope was closed. Every scope also keeps
+// CPU timing, so it remains useful on contexts without timer queries.
+namespace GLTimerQueries {
+
+struct Scope {
+    std::string Name;
+    // Exponentially smoothed durations in milliseconds.
+    double CpuMs = 0.0;
+    double GpuMs = 0.0;
+    uint64_t Samples = 0;
+    bool HasGpuResult = false;
+};
+
+bool IsAvailable();
+
+// Only one scope can be open at a time because GL_TIME_ELAPSED queries do not
+// nest. Begin fails and fills error when a scope is already open.
+bool Begin(const std::string& name, std::string& error);
+bool End(std::string& error);
+
+// Closes a scope the script left open and collects finished queries.
+void BeginFrame();
+// Drops all scopes and query objects, e.g. when the script is recompiled.
+void Reset();
+
+std::size_t GetScopeCount();
+const Scope& GetScope(std::size_t index);
+const Scope* FindScope(const std::string& name);
+std::size_t GetPendingQueryCount();
+
+} // namespace GLTimerQueries
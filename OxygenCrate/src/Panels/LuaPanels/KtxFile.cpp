@@ -0,0 +1,96 @@
+#include "KtxFile.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+constexpr uint32_t kEndianness = 0x04030201;
+constexpr std::size_t kHeaderSize = 64;
+
+uint32_t ReadU32(const uint8_t* data) {
+    uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+namespace KtxFile {
+
+bool Parse(const std::string& bytes, Image& image, std::string& error) {
+    image = Image{};
+    if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kIdentifier, sizeof(kIdentifier)) != 0) {
+        error = "not a KTX 1.1 file";
+        return false;
+    }
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(bytes.data());
+    // Header fields after the identifier, in file order.
+    uint32_t header[13];
+    for (int i = 0; i < 13; ++i)
+        header[i] = ReadU32(base + sizeof(kIdentifier) + i * 4);
+
+    if (header[0] != kEndianness) {
+        error = "big-endian KTX files are not supported";
+        return false;
+    }
+    const uint32_t glType = header[1];
+    const uint32_t glFormat = header[3];
+    const uint32_t glInternalFormat = header[4];
+    const uint32_t width = header[6];
+    const uint32_t height = header[7];
+    const uint32_t depth = header[8];
+    const uint32_t arrayElements = header[9];
+    const uint32_t faces = header[10];
+    const uint32_t mipLevels = header[11];
+    const uint32_t keyValueBytes = header[12];
+
+    if (width == 0 || height == 0 || depth > 1 || arrayElements > 0 || faces != 1) {
+        error = "only 2D textures are supported";
+        return false;
+    }
+    if (mipLevels > 32) {
+        error = "invalid mip level count";
+        return false;
+    }
+    if ((glType == 0) != (glFormat == 0)) {
+        error = "inconsistent glType/glFormat";
+        return false;
+    }
+
+    image.InternalFormat = glInternalFormat;
+    image.Format = glFormat;
+    image.Type = glType;
+    image.Width = width;
+    image.Height = height;
+    image.GenerateMipmaps = mipLevels == 0;
+
+    std::size_t offset = kHeaderSize + keyValueBytes;
+    const uint32_t levelCount = mipLevels == 0 ? 1 : mipLevels;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        if (offset + 4 > bytes.size()) {
+            error = "truncated mip level " + std::to_string(level);
+            return false;
+        }
+        const std::size_t size = ReadU32(base + offset);
+        offset += 4;
+        if (size > bytes.size() - offset) {
+            error = "truncated mip level " + std::to_string(level);
+            return false;
+        }
+
+        Level entry;
+        entry.Width = width >> level ? width >> level : 1;
+        entry.Height = height >> level ? height >> level : 1;
+        entry.Data = base + offset;
+        entry.Size = size;
+        image.Levels.push_back(entry);
+
+        // Level data is padded to a multiple of four bytes.
+        offset += (size + 3) & ~static_cast<std::size_t>(3);
+    }
+    return true;
+}
+
+} // namespace KtxFile
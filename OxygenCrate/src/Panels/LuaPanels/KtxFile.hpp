@@ -0,0 +1,40 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reads KTX 1.1 containers holding a single 2D texture and its mip chain.
+// Level data is not copied; the pointers refer into the parsed bytes.
+namespace KtxFile {
+
+struct Level {
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    const uint8_t* Data = nullptr;
+    std::size_t Size = 0;
+};
+
+struct Image {
+    GLenum InternalFormat = 0;
+    // Zero for compressed payloads.
+    GLenum Format = 0;
+    GLenum Type = 0;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    // Set when the file stores no mip levels beyond the base and asks the
+    // loader to generate them (numberOfMipmapLevels == 0).
+    bool GenerateMipmaps = false;
+    std::vector<Level> Levels;
+
+    bool IsCompressed() const { return Type == 0; }
+};
+
+// Returns false and fills error for anything other than a little-endian 2D
+// texture (no arrays, cube maps or 3D textures) or when the data is truncated.
+bool Parse(const std::string& bytes, Image& image, std::string& error);
+
+} // namespace KtxFile
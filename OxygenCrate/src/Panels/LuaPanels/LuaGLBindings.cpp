@@ -1,54 +1,855 @@
 #include "LuaGLBindings.hpp"
+#include "GLBackend.hpp"
+#include "GLDeletionQueue.hpp"
+#include "GLFrameStats.hpp"
+#include "GLTimerQueries.hpp"
 #include "GLWrappers.hpp"
+#include "QuadBatch.hpp"
+#include "ShaderProgramCache.hpp"
+#include "TexturePool.hpp"
+#include "VertexPacking.hpp"
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <functional>
 #include <stdexcept>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 namespace {
 
 struct BufferResource {
     GLuint id = 0;
     GLenum target = GL_ARRAY_BUFFER;
+    GLenum indexType = 0;
+    GLsizei indexCount = 0;
 };
 
 struct VertexArrayResource {
     GLuint id = 0;
+    int elementBuffer = 0;
 };
 
 struct ShaderResource {
     GLuint program = 0;
+    bool pending = false;
+    bool failed = false;
+    std::string error;
+};
+
+struct PendingShaderResource {
+    ShaderProgramCache::PendingProgram program;
+    sol::protected_function callback;
+};
+
+enum class CommandType : uint8_t {
+    ClearColor,
+    Clear,
+    Viewport,
+    UseShader,
+    BindVertexArray,
+    BindBuffer,
+    UniformFloat,
+    DrawElements,
+    DrawArrays,
+    DrawElementsInstanced,
+    DrawArraysInstanced,
+    DrawMesh
+};
+
+// One recorded GL action. Handles are resolved at execution time so a list
+// stays valid while the resources it references are alive.
+struct RecordedCommand {
+    CommandType type = CommandType::Clear;
+    int handle = 0;
+    GLenum target = 0;
+    GLint location = -1;
+    GLint first = 0;
+    GLsizei count = 0;
+    GLsizei instances = 0;
+    GLenum indexType = 0;
+    intptr_t offset = 0;
+    float values[4] = {};
+};
+
+struct CommandListResource {
+    std::vector<RecordedCommand> commands;
+};
+
+struct MeshAttributeBinding {
+    GLuint location = 0;
+    GLuint divisor = 0;
+};
+
+// A mesh owns its vertex array and buffers. The attribute layout is recorded in
+// the VAO once at creation; later uploads reuse the same buffer names, so the
+// VAO never has to be set up again.
+struct MeshResource {
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    std::vector<VertexPacking::Attribute> formats;
+    std::vector<MeshAttributeBinding> bindings;
+    GLsizei stride = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLenum usage = GL_STATIC_DRAW;
+    GLsizei vertexCount = 0;
+    std::size_t vertexBytes = 0;
+    GLenum indexType = 0;
+    GLsizei indexCount = 0;
+    std::size_t indexBytes = 0;
 };
 
 std::unordered_map<int, BufferResource> s_Buffers;
 std::unordered_map<int, VertexArrayResource> s_VertexArrays;
 std::unordered_map<int, ShaderResource> s_Shaders;
+std::unordered_map<int, CommandListResource> s_CommandLists;
+std::unordered_map<int, MeshResource> s_Meshes;
+std::map<int, PendingShaderResource> s_PendingShaders;
+int s_FallbackShader = 0;
+// Set while the bound program is still compiling and no fallback is ready.
+bool s_SkipDraws = false;
 int s_NextHandle = 1;
+int s_BoundVertexArray = 0;
+// Program and unit 0 texture last bound through CountedGL this frame, so
+// internal draws can put the script's state back.
+GLuint s_BoundProgram = 0;
+GLuint s_BoundTexture0 = 0;
+std::unordered_map<int, std::unique_ptr<QuadBatch>> s_QuadBatches;
+std::function<GLuint(int)> s_TextureResolver;
+GLuint s_WhiteTexture = 0;
+
+// GL entry points used by the bindings. Each one forwards to the active
+// GLBackend and updates the per-frame statistics.
+namespace CountedGL {
+
+void UseProgram(GLuint program) {
+    GLBackend::Get().UseProgram(program);
+    s_BoundProgram = program;
+    ++GLFrameStats::Current().ShaderBinds;
+}
+
+void BindVertexArray(GLuint id) {
+    GLBackend::Get().BindVertexArray(id);
+    ++GLFrameStats::Current().VertexArrayBinds;
+}
+
+void BindBuffer(GLenum target, GLuint id) {
+    GLBackend::Get().BindBuffer(target, id);
+    ++GLFrameStats::Current().BufferBinds;
+}
+
+void BindTexture(GLuint unit, GLenum target, GLuint id) {
+    GLBackend::Get().BindTexture(unit, target, id);
+    if (unit == 0 && target == GL_TEXTURE_2D)
+        s_BoundTexture0 = id;
+    ++GLFrameStats::Current().TextureBinds;
+}
+
+void Uniform1f(GLint location, float value) {
+    GLBackend::Get().Uniform1f(location, value);
+    ++GLFrameStats::Current().UniformUpdates;
+}
+
+bool SetUniformFloat(GLuint program, const char* name, float value) {
+    ++GLFrameStats::Current().UniformUpdates;
+    return GLBackend::Get().SetUniformFloat(program, name, value);
+}
+
+void Clear(GLbitfield mask) {
+    GLBackend::Get().Clear(mask);
+    ++GLFrameStats::Current().Clears;
+}
+
+void CountBufferUpload(std::size_t bytes) {
+    GLFrameStats::Counters& stats = GLFrameStats::Current();
+    ++stats.BufferUploads;
+    stats.BufferBytes += bytes;
+}
+
+void UpdateBufferData(GLuint id, GLenum target, std::size_t size, const void* data, GLenum usage) {
+    GLBackend::Get().UpdateBuffer(id, target, size, data, usage);
+    CountBufferUpload(size);
+}
+
+// Counts individual draws, so a native multi-draw of N entries and the
+// one-draw-per-entry fallback report the same number.
+void CountDraws(GLsizei count) {
+    GLFrameStats::Current().DrawCalls += static_cast<uint32_t>(count);
+}
+
+void DrawArrays(GLenum mode, GLint first, GLsizei count) {
+    GLBackend::Get().DrawArrays(mode, first, count);
+    CountDraws(1);
+}
+
+void DrawElements(GLenum mode, GLsizei count, GLenum type, intptr_t offset) {
+    GLBackend::Get().DrawElements(mode, count, type, offset);
+    CountDraws(1);
+}
+
+void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    GLBackend::Get().DrawArraysInstanced(mode, first, count, instances);
+    CountDraws(1);
+}
+
+void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, intptr_t offset, GLsizei instances) {
+    GLBackend::Get().DrawElementsInstanced(mode, count, type, offset, instances);
+    CountDraws(1);
+}
+
+void MultiDrawArrays(GLenum mode, const GLint* firsts, const GLsizei* counts, GLsizei drawCount) {
+    GLBackend::Get().MultiDrawArrays(mode, firsts, counts, drawCount);
+    CountDraws(drawCount);
+}
+
+void MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount) {
+    GLBackend::Get().MultiDrawElements(mode, counts, type, indices, drawCount);
+    CountDraws(drawCount);
+}
+
+void DrawArraysIndirect(GLenum mode, const void* indirect) {
+    GLBackend::Get().DrawArraysIndirect(mode, indirect);
+    CountDraws(1);
+}
+
+void DrawElementsIndirect(GLenum mode, GLenum type, const void* indirect) {
+    GLBackend::Get().DrawElementsIndirect(mode, type, indirect);
+    CountDraws(1);
+}
+
+void MultiDrawArraysIndirect(GLenum mode, const void* indirect, GLsizei drawCount, GLsizei stride) {
+    GLBackend::Get().MultiDrawArraysIndirect(mode, indirect, drawCount, stride);
+    CountDraws(drawCount);
+}
+
+void MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) {
+    GLBackend::Get().MultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    CountDraws(drawCount);
+}
+
+} // namespace CountedGL
+
+bool SupportsFeature(GLBackend::Feature feature) {
+    return GLBackend::Get().Supports(feature);
+}
 
 int StoreBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
-    GLuint id = Flux::GL::CreateBuffer(target, static_cast<std::size_t>(size), data, usage);
-    Flux::GL::BindBuffer(target, 0);
+    GLBackend& backend = GLBackend::Get();
+    GLuint id = backend.CreateBuffer(target, static_cast<std::size_t>(size), data, usage);
+    // Internal cleanup, not a script bind: keep it out of the frame stats.
+    backend.BindBuffer(target, 0);
+    CountedGL::CountBufferUpload(static_cast<std::size_t>(size));
     const int handle = s_NextHandle++;
     s_Buffers[handle] = BufferResource{ id, target };
     return handle;
 }
 
+GLsizei IndexTypeSize(GLenum type) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_UNSIGNED_INT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+GLuint MaxIndexForType(GLenum type) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+        return 0xFFu;
+    case GL_UNSIGNED_SHORT:
+        return 0xFFFFu;
+    default:
+        return 0xFFFFFFFFu;
+    }
+}
+
+// Picks the narrowest type that holds every index. Byte indices are only used
+// when asked for explicitly: several desktop drivers (and ANGLE) convert them
+// on the CPU, which costs more than the bandwidth they save.
+GLenum InferIndexType(const std::vector<unsigned int>& indices) {
+    const unsigned int maxIndex = indices.empty() ? 0u : *std::max_element(indices.begin(), indices.end());
+    return maxIndex <= MaxIndexForType(GL_UNSIGNED_SHORT) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+// Narrows indices to the requested type. Returns false when the type is not a
+// valid index type or an index does not fit.
+bool PackIndices(const std::vector<unsigned int>& indices, GLenum type, std::vector<uint8_t>& packed) {
+    const GLsizei size = IndexTypeSize(type);
+    if (size == 0)
+        return false;
+    const GLuint limit = MaxIndexForType(type);
+    packed.resize(indices.size() * static_cast<std::size_t>(size));
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        const unsigned int index = indices[i];
+        if (index > limit)
+            return false;
+        if (type == GL_UNSIGNED_BYTE) {
+            packed[i] = static_cast<uint8_t>(index);
+        } else if (type == GL_UNSIGNED_SHORT) {
+            const auto value = static_cast<uint16_t>(index);
+            std::memcpy(packed.data() + i * 2, &value, sizeof(value));
+        } else {
+            std::memcpy(packed.data() + i * 4, &index, sizeof(index));
+        }
+    }
+    return true;
+}
+
+// Element buffer bindings are VAO state, so they are tracked per vertex array
+// to let indexed draws look up the type of the bound index buffer.
+void TrackElementBuffer(int buffer) {
+    auto it = s_VertexArrays.find(s_BoundVertexArray);
+    if (it != s_VertexArrays.end())
+        it->second.elementBuffer = buffer;
+}
+
+int StoreIndexBuffer(const std::vector<unsigned int>& indices, GLenum type, GLenum usage) {
+    std::vector<uint8_t> packed;
+    if (!PackIndices(indices, type, packed))
+        return -1;
+    const int handle = StoreBuffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.size()), packed.data(), usage);
+    s_Buffers[handle].indexType = type;
+    s_Buffers[handle].indexCount = static_cast<GLsizei>(indices.size());
+    // StoreBuffer unbinds the element target, which detaches it from the bound VAO.
+    TrackElementBuffer(0);
+    return handle;
+}
+
+const BufferResource* FindBoundIndexBuffer() {
+    auto vertexArray = s_VertexArrays.find(s_BoundVertexArray);
+    if (vertexArray == s_VertexArrays.end() || vertexArray->second.elementBuffer == 0)
+        return nullptr;
+    auto it = s_Buffers.find(vertexArray->second.elementBuffer);
+    return it != s_Buffers.end() ? &it->second : nullptr;
+}
+
+std::string FormatIndexType(GLenum type) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%04X", type);
+    return text;
+}
+
+// Fills in an omitted index type from the bound index buffer and rejects draws
+// whose type or index range does not match what the buffer holds, raising a Lua
+// error so a bad draw is never silently dropped. Draws against buffers the
+// bindings do not know about are passed through unchanged.
+void ResolveIndexedDraw(const char* function, GLsizei count, GLenum& type, intptr_t offset) {
+    const BufferResource* indices = FindBoundIndexBuffer();
+    if (!indices || indices->indexType == 0) {
+        if (IndexTypeSize(type) == 0)
+            throw std::runtime_error(std::string(function) + ": invalid index type " + FormatIndexType(type));
+        return;
+    }
+    if (type == 0)
+        type = indices->indexType;
+    if (type != indices->indexType) {
+        throw std::runtime_error(std::string(function) + ": index type " + FormatIndexType(type)
+            + " does not match the bound index buffer (" + FormatIndexType(indices->indexType) + ")");
+    }
+    if (offset < 0 || offset % IndexTypeSize(type) != 0)
+        throw std::runtime_error(std::string(function) + ": offset " + std::to_string(offset) + " is not aligned to the index type");
+    const intptr_t first = offset / IndexTypeSize(type);
+    if (count < 0 || first + count > indices->indexCount) {
+        throw std::runtime_error(std::string(function) + ": draws indices " + std::to_string(first) + ".." + std::to_string(first + count)
+            + " but the bound index buffer holds " + std::to_string(indices->indexCount));
+    }
+}
+
+// Reads a layout description ({ type, size, normalized, offset } per attribute)
+// produced by BufferLayout:packing() into packer attributes.
+std::vector<VertexPacking::Attribute> ReadPackedLayout(const sol::table& layout) {
+    std::vector<VertexPacking::Attribute> attributes;
+    const std::size_t count = layout.size();
+    attributes.reserve(count);
+    for (std::size_t i = 1; i <= count; ++i) {
+        sol::table element = layout.get<sol::table>(i);
+        VertexPacking::Attribute attribute;
+        attribute.Type = element.get_or("type", static_cast<unsigned int>(GL_FLOAT));
+        attribute.Size = element.get_or("size", 0);
+        attribute.Normalized = element.get_or("normalized", false);
+        attribute.Offset = element.get_or("offset", 0);
+        attributes.push_back(attribute);
+    }
+    return attributes;
+}
+
 int StoreVertexArray() {
-    GLuint id = Flux::GL::CreateVertexArray();
+    GLuint id = GLBackend::Get().CreateVertexArray();
     const int handle = s_NextHandle++;
     s_VertexArrays[handle] = VertexArrayResource{ id };
     return handle;
 }
 
+// A synchronous compile or link failure raises a Lua error carrying the log,
+// so it reaches the console like any other script error.
 int StoreShaderProgram(const std::string& vertexSrc, const std::string& fragmentSrc) {
-    GLuint program = Flux::GL::CreateShaderProgram(vertexSrc, fragmentSrc);
+    ShaderResource resource;
+    resource.program = GLBackend::Get().CreateProgram(vertexSrc, fragmentSrc, resource.error);
+    if (resource.program == 0)
+        throw std::runtime_error("create_shader_program: " + resource.error);
+    const int handle = s_NextHandle++;
+    s_Shaders[handle] = std::move(resource);
+    return handle;
+}
+
+int StorePendingShaderProgram(const std::string& vertexSrc, const std::string& fragmentSrc, sol::protected_function callback) {
+    const int handle = s_NextHandle++;
+    ShaderResource resource;
+    resource.pending = true;
+    s_Shaders[handle] = resource;
+    s_PendingShaders[handle] = PendingShaderResource{ GLBackend::Get().BeginProgram(vertexSrc, fragmentSrc), std::move(callback) };
+    return handle;
+}
+
+// Programs that are still compiling (or failed) resolve to the fallback
+// program; when there is none, draws are skipped until the program is ready.
+GLuint ResolveProgram(int handle) {
+    s_SkipDraws = false;
+    auto it = s_Shaders.find(handle);
+    if (it == s_Shaders.end())
+        return 0;
+    if (!it->second.pending && !it->second.failed)
+        return it->second.program;
+
+    auto fallback = s_Shaders.find(s_FallbackShader);
+    if (fallback != s_Shaders.end() && !fallback->second.pending && !fallback->second.failed)
+        return fallback->second.program;
+    s_SkipDraws = true;
+    return 0;
+}
+
+bool CanDraw() {
+    return !s_SkipDraws;
+}
+
+int StoreCommandList() {
     const int handle = s_NextHandle++;
-    s_Shaders[handle] = ShaderResource{ program };
+    s_CommandLists[handle] = CommandListResource{};
     return handle;
 }
 
+CommandListResource* FindCommandList(int handle) {
+    auto it = s_CommandLists.find(handle);
+    return it != s_CommandLists.end() ? &it->second : nullptr;
+}
+
+bool RecordCommand(int listHandle, const RecordedCommand& command) {
+    CommandListResource* list = FindCommandList(listHandle);
+    if (!list)
+        return false;
+    list->commands.push_back(command);
+    return true;
+}
+
+// Uploads through GL_COPY_WRITE_BUFFER so neither the array buffer binding nor
+// the element buffer of whatever VAO is bound gets disturbed. The buffer keeps
+// its name, so VAOs that reference it stay valid.
+void UploadMeshBuffer(GLuint id, const std::vector<uint8_t>& data, GLenum usage, std::size_t& capacity) {
+    const bool reallocate = data.size() > capacity || data.size() < capacity / 2;
+    GLBackend::Get().CopyIntoBuffer(id, data.size(), data.data(), usage, reallocate);
+    if (reallocate)
+        capacity = data.size();
+    CountedGL::CountBufferUpload(data.size());
+}
+
+bool UploadMeshVertices(MeshResource& mesh, const std::vector<float>& values, std::string& error) {
+    std::vector<uint8_t> packed;
+    if (!VertexPacking::Pack(values, mesh.formats, mesh.stride, packed, error))
+        return false;
+    UploadMeshBuffer(mesh.vertexBuffer, packed, mesh.usage, mesh.vertexBytes);
+    mesh.vertexCount = static_cast<GLsizei>(packed.size() / static_cast<std::size_t>(mesh.stride));
+    return true;
+}
+
+bool UploadMeshIndices(MeshResource& mesh, const std::vector<unsigned int>& indices, GLenum type, std::string& error) {
+    std::vector<uint8_t> packed;
+    if (!PackIndices(indices, type, packed)) {
+        error = "indices do not fit the index type";
+        return false;
+    }
+    UploadMeshBuffer(mesh.indexBuffer, packed, mesh.usage, mesh.indexBytes);
+    mesh.indexType = type;
+    mesh.indexCount = static_cast<GLsizei>(indices.size());
+    return true;
+}
+
+void DeleteMeshObjects(const MeshResource& mesh) {
+    GLBackend& backend = GLBackend::Get();
+    backend.DeleteObject(GLDeletionQueue::ObjectType::VertexArray, mesh.vertexArray);
+    backend.DeleteObject(GLDeletionQueue::ObjectType::Buffer, mesh.vertexBuffer);
+    backend.DeleteObject(GLDeletionQueue::ObjectType::Buffer, mesh.indexBuffer);
+}
+
+// Records the attribute layout and buffer bindings in the mesh VAO, then
+// rebinds the script's vertex array. Called once.
+void SetupMeshVertexArray(const MeshResource& mesh) {
+    CountedGL::BindVertexArray(mesh.vertexArray);
+    GLBackend& backend = GLBackend::Get();
+    backend.BindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+    for (std::size_t i = 0; i < mesh.formats.size(); ++i) {
+        const VertexPacking::Attribute& format = mesh.formats[i];
+        const MeshAttributeBinding& binding = mesh.bindings[i];
+        backend.EnableVertexAttribArray(binding.location);
+        backend.VertexAttribPointer(binding.location, format.Size, format.Type, format.Normalized, mesh.stride, format.Offset);
+        if (binding.divisor != 0)
+            backend.VertexAttribDivisor(binding.location, binding.divisor);
+    }
+    backend.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    auto previous = s_VertexArrays.find(s_BoundVertexArray);
+    CountedGL::BindVertexArray(previous != s_VertexArrays.end() ? previous->second.id : 0);
+    backend.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DrawMeshResource(const MeshResource& mesh, GLenum mode, GLsizei instances) {
+    if (mesh.indexCount > 0) {
+        if (instances > 1)
+            CountedGL::DrawElementsInstanced(mode, mesh.indexCount, mesh.indexType, 0, instances);
+        else
+            CountedGL::DrawElements(mode, mesh.indexCount, mesh.indexType, 0);
+    } else if (mesh.vertexCount > 0) {
+        if (instances > 1)
+            CountedGL::DrawArraysInstanced(mode, 0, mesh.vertexCount, instances);
+        else
+            CountedGL::DrawArrays(mode, 0, mesh.vertexCount);
+    }
+}
+
+std::vector<unsigned int> ReadIndexTable(const sol::table& table) {
+    std::vector<unsigned int> indices(table.size());
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        indices[i] = table.get<unsigned int>(i + 1);
+    return indices;
+}
+
+// Texture 0 and unknown ids sample a 1x1 white texture so untextured quads
+// keep their vertex color.
+GLuint ResolveTexture(int texture) {
+    GLuint id = (texture != 0 && s_TextureResolver) ? s_TextureResolver(texture) : 0;
+    if (id != 0)
+        return id;
+    if (s_WhiteTexture == 0) {
+        const uint8_t white[4] = { 255, 255, 255, 255 };
+        GLBackend& backend = GLBackend::Get();
+        s_WhiteTexture = backend.CreateTextureName();
+        backend.TexImage2D(s_WhiteTexture, 0, GL_RGBA8, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        backend.SetTextureSampling(s_WhiteTexture, GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, 0);
+    }
+    return s_WhiteTexture;
+}
+
+// Accepts 0xRRGGBBAA numbers or { r, g, b, a } tables with 0..1 components.
+uint32_t ReadColor(const sol::object& color) {
+    if (color.is<double>())
+        return static_cast<uint32_t>(color.as<double>());
+    if (!color.is<sol::table>())
+        return 0xFFFFFFFFu;
+    sol::table table = color.as<sol::table>();
+    auto channel = [&](int index, float fallback) {
+        const float value = std::clamp(table.get_or(index, fallback), 0.0f, 1.0f);
+        return static_cast<uint32_t>(value * 255.0f + 0.5f);
+    };
+    return (channel(1, 1.0f) << 24) | (channel(2, 1.0f) << 16) | (channel(3, 1.0f) << 8) | channel(4, 1.0f);
+}
+
+QuadBatch* FindQuadBatch(int handle) {
+    auto it = s_QuadBatches.find(handle);
+    return it != s_QuadBatches.end() ? it->second.get() : nullptr;
+}
+
+// Draws every run of the batch; returns the number of draw calls issued. The
+// script's vertex array, program and unit 0 texture are bound again afterwards.
+int FlushQuadBatch(QuadBatch& batch) {
+    const std::vector<QuadBatchRun>& runs = batch.Upload();
+    if (runs.empty())
+        return 0;
+
+    const GLuint previousProgram = s_BoundProgram;
+    const GLuint previousTexture = s_BoundTexture0;
+    const bool previousSkipDraws = s_SkipDraws;
+    CountedGL::BindVertexArray(batch.GetVertexArray());
+    const GLenum indexType = batch.GetIndexType();
+    const intptr_t quadIndexBytes = static_cast<intptr_t>(IndexTypeSize(indexType)) * 6;
+    int shader = 0;
+    int texture = -1;
+    int draws = 0;
+    for (const QuadBatchRun& run : runs) {
+        // Shader 0 keeps whatever program the script bound before flushing.
+        if (run.Shader != 0 && run.Shader != shader) {
+            CountedGL::UseProgram(ResolveProgram(run.Shader));
+            shader = run.Shader;
+        }
+        if (run.Texture != texture) {
+            CountedGL::BindTexture(0, GL_TEXTURE_2D, ResolveTexture(run.Texture));
+            texture = run.Texture;
+        }
+        if (!CanDraw())
+            continue;
+        CountedGL::DrawElements(GL_TRIANGLES, run.QuadCount * 6, indexType, run.FirstQuad * quadIndexBytes);
+        ++draws;
+    }
+
+    auto previous = s_VertexArrays.find(s_BoundVertexArray);
+    CountedGL::BindVertexArray(previous != s_VertexArrays.end() ? previous->second.id : 0);
+    if (s_BoundProgram != previousProgram)
+        CountedGL::UseProgram(previousProgram);
+    if (s_BoundTexture0 != previousTexture)
+        CountedGL::BindTexture(0, GL_TEXTURE_2D, previousTexture);
+    s_SkipDraws = previousSkipDraws;
+    return draws;
+}
+
+bool IsDrawCommand(CommandType type) {
+    return type == CommandType::DrawElements || type == CommandType::DrawArrays
+        || type == CommandType::DrawElementsInstanced || type == CommandType::DrawArraysInstanced
+        || type == CommandType::DrawMesh;
+}
+
+bool IsStateBarrier(CommandType type) {
+    return type == CommandType::ClearColor || type == CommandType::Clear || type == CommandType::Viewport;
+}
+
+// Reorders draw packets between barriers (clears, viewport changes) so that
+// draws sharing a shader and vertex array end up adjacent. A packet is every
+// command up to and including a draw; it is prefixed with the shader and vertex
+// array that were effective when it was recorded, so it no longer depends on
+// the packets before it. Uniforms a draw relies on must be recorded in its own
+// packet for the reordering to be safe.
+void SortCommandList(CommandListResource& list) {
+    struct Packet {
+        int shader = 0;
+        int vertexArray = 0;
+        size_t first = 0;
+        size_t last = 0;
+        // Mesh draws bind their own vertex array; vertexArray is the mesh handle.
+        bool mesh = false;
+    };
+
+    std::vector<RecordedCommand> sorted;
+    sorted.reserve(list.commands.size());
+    std::vector<Packet> packets;
+    int shader = 0;
+    int vertexArray = 0;
+    size_t packetStart = 0;
+
+    auto flushPackets = [&](size_t end) {
+        std::stable_sort(packets.begin(), packets.end(), [](const Packet& a, const Packet& b) {
+            if (a.shader != b.shader)
+                return a.shader < b.shader;
+            return a.vertexArray < b.vertexArray;
+        });
+        for (const Packet& packet : packets) {
+            const bool startsWithShader = list.commands[packet.first].type == CommandType::UseShader
+                && list.commands[packet.first].handle == packet.shader;
+            const bool selfContained = packet.mesh
+                ? startsWithShader
+                : packet.last - packet.first >= 2 && startsWithShader
+                    && list.commands[packet.first + 1].type == CommandType::BindVertexArray
+                    && list.commands[packet.first + 1].handle == packet.vertexArray;
+            if (selfContained) {
+                sorted.insert(sorted.end(), list.commands.begin() + packet.first, list.commands.begin() + packet.last + 1);
+                continue;
+            }
+            RecordedCommand useShader;
+            useShader.type = CommandType::UseShader;
+            useShader.handle = packet.shader;
+            sorted.push_back(useShader);
+            if (!packet.mesh) {
+                RecordedCommand bindVertexArray;
+                bindVertexArray.type = CommandType::BindVertexArray;
+                bindVertexArray.handle = packet.vertexArray;
+                sorted.push_back(bindVertexArray);
+            }
+            sorted.insert(sorted.end(), list.commands.begin() + packet.first, list.commands.begin() + packet.last + 1);
+        }
+        packets.clear();
+        sorted.insert(sorted.end(), list.commands.begin() + packetStart, list.commands.begin() + end);
+    };
+
+    for (size_t i = 0; i < list.commands.size(); ++i) {
+        const RecordedCommand& command = list.commands[i];
+        if (command.type == CommandType::UseShader)
+            shader = command.handle;
+        else if (command.type == CommandType::BindVertexArray)
+            vertexArray = command.handle;
+
+        if (IsStateBarrier(command.type)) {
+            flushPackets(i);
+            sorted.push_back(command);
+            packetStart = i + 1;
+        } else if (command.type == CommandType::DrawMesh) {
+            packets.push_back(Packet{ shader, command.handle, packetStart, i, true });
+            packetStart = i + 1;
+        } else if (IsDrawCommand(command.type)) {
+            packets.push_back(Packet{ shader, vertexArray, packetStart, i });
+            packetStart = i + 1;
+        }
+    }
+    flushPackets(list.commands.size());
+    list.commands = std::move(sorted);
+}
+
+void ExecuteCommandList(const CommandListResource& list) {
+    GLuint currentProgram = 0;
+    GLuint currentVertexArray = 0;
+    bool programKnown = false;
+    bool vertexArrayKnown = false;
+
+    for (const RecordedCommand& command : list.commands) {
+        switch (command.type) {
+        case CommandType::ClearColor:
+            GLBackend::Get().ClearColor(command.values[0], command.values[1], command.values[2], command.values[3]);
+            break;
+        case CommandType::Clear:
+            CountedGL::Clear(command.target);
+            break;
+        case CommandType::Viewport:
+            GLBackend::Get().Viewport(static_cast<int>(command.values[0]), static_cast<int>(command.values[1]),
+                static_cast<int>(command.values[2]), static_cast<int>(command.values[3]));
+            break;
+        case CommandType::UseShader: {
+            const GLuint program = ResolveProgram(command.handle);
+            if (!programKnown || program != currentProgram) {
+                CountedGL::UseProgram(program);
+                currentProgram = program;
+                programKnown = true;
+            }
+            break;
+        }
+        case CommandType::BindVertexArray: {
+            auto it = s_VertexArrays.find(command.handle);
+            const GLuint id = it != s_VertexArrays.end() ? it->second.id : 0;
+            if (!vertexArrayKnown || id != currentVertexArray) {
+                CountedGL::BindVertexArray(id);
+                currentVertexArray = id;
+                vertexArrayKnown = true;
+            }
+            s_BoundVertexArray = id != 0 ? command.handle : 0;
+            break;
+        }
+        case CommandType::BindBuffer: {
+            auto it = s_Buffers.find(command.handle);
+            if (it == s_Buffers.end())
+                break;
+            const GLenum target = command.target != 0 ? command.target : it->second.target;
+            CountedGL::BindBuffer(target, it->second.id);
+            if (target == GL_ELEMENT_ARRAY_BUFFER)
+                TrackElementBuffer(command.handle);
+            break;
+        }
+        case CommandType::UniformFloat: {
+            auto it = s_Shaders.find(command.handle);
+            if (it == s_Shaders.end() || command.location < 0)
+                break;
+            const GLuint program = it->second.program;
+            if (programKnown && program == currentProgram) {
+                CountedGL::Uniform1f(command.location, command.values[0]);
+            } else {
+                CountedGL::UseProgram(program);
+                CountedGL::Uniform1f(command.location, command.values[0]);
+                if (programKnown)
+                    CountedGL::UseProgram(currentProgram);
+                else {
+                    currentProgram = program;
+                    programKnown = true;
+                }
+            }
+            break;
+        }
+        case CommandType::DrawElements: {
+            GLenum indexType = command.indexType;
+            ResolveIndexedDraw("cmd_draw_elements", command.count, indexType, command.offset);
+            if (CanDraw())
+                CountedGL::DrawElements(command.target, command.count, indexType, command.offset);
+            break;
+        }
+        case CommandType::DrawArrays:
+            if (CanDraw())
+                CountedGL::DrawArrays(command.target, command.first, command.count);
+            break;
+        case CommandType::DrawElementsInstanced: {
+            GLenum indexType = command.indexType;
+            ResolveIndexedDraw("cmd_draw_elements_instanced", command.count, indexType, command.offset);
+            if (CanDraw())
+                CountedGL::DrawElementsInstanced(command.target, command.count, indexType, command.offset, command.instances);
+            break;
+        }
+        case CommandType::DrawArraysInstanced:
+            if (CanDraw())
+                CountedGL::DrawArraysInstanced(command.target, command.first, command.count, command.instances);
+            break;
+        case CommandType::DrawMesh: {
+            auto it = s_Meshes.find(command.handle);
+            if (it == s_Meshes.end())
+                break;
+            const MeshResource& mesh = it->second;
+            if (!vertexArrayKnown || mesh.vertexArray != currentVertexArray) {
+                CountedGL::BindVertexArray(mesh.vertexArray);
+                currentVertexArray = mesh.vertexArray;
+                vertexArrayKnown = true;
+            }
+            s_BoundVertexArray = 0;
+            if (CanDraw())
+                DrawMeshResource(mesh, command.target != 0 ? command.target : mesh.mode, command.instances);
+            break;
+        }
+        }
+    }
+}
+
+// Falls back to one draw per entry where the context has no native multi-draw.
+void MultiDrawArrays(GLenum mode, const std::vector<GLint>& firsts, const std::vector<GLsizei>& counts) {
+    const GLsizei drawCount = static_cast<GLsizei>(std::min(firsts.size(), counts.size()));
+    if (drawCount == 0)
+        return;
+#if !defined(__ANDROID__)
+    if (SupportsFeature(GLBackend::Feature::MultiDraw)) {
+        CountedGL::MultiDrawArrays(mode, firsts.data(), counts.data(), drawCount);
+        return;
+    }
+#endif
+    for (GLsizei i = 0; i < drawCount; ++i)
+        CountedGL::DrawArrays(mode, firsts[i], counts[i]);
+}
+
+void MultiDrawElements(GLenum mode, const std::vector<GLsizei>& counts, GLenum type, const std::vector<intptr_t>& offsets) {
+    const GLsizei drawCount = static_cast<GLsizei>(std::min(counts.size(), offsets.size()));
+    if (drawCount == 0)
+        return;
+#if !defined(__ANDROID__)
+    if (SupportsFeature(GLBackend::Feature::MultiDraw)) {
+        std::vector<const void*> indices(static_cast<size_t>(drawCount));
+        for (GLsizei i = 0; i < drawCount; ++i)
+            indices[i] = reinterpret_cast<const void*>(offsets[i]);
+        CountedGL::MultiDrawElements(mode, counts.data(), type, indices.data(), drawCount);
+        return;
+    }
+#endif
+    for (GLsizei i = 0; i < drawCount; ++i)
+        CountedGL::DrawElements(mode, counts[i], type, offsets[i]);
+}
+
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+// Indirect commands are read from the buffer bound to GL_DRAW_INDIRECT_BUFFER.
+bool BindIndirectBuffer(int handle) {
+    auto it = s_Buffers.find(handle);
+    if (it == s_Buffers.end() || it->second.target != GL_DRAW_INDIRECT_BUFFER)
+        return false;
+    CountedGL::BindBuffer(GL_DRAW_INDIRECT_BUFFER, it->second.id);
+    return true;
+}
+#endif
+
 sol::table GetOrCreateTable(sol::state& lua, const char* name) {
     sol::object existing = lua[name];
     if (existing.is<sol::table>())
@@ -65,39 +866,61 @@ void Register(sol::state& lua) {
         sol::table glTable = GetOrCreateTable(lua, tableName);
 
         glTable.set_function("clear_color", [](float r, float g, float b, float a) {
-            Flux::GL::ClearColor(r, g, b, a);
+            GLBackend::Get().ClearColor(r, g, b, a);
         });
         glTable.set_function("clear", [](unsigned int mask) {
-            Flux::GL::Clear(mask);
+            CountedGL::Clear(mask);
         });
         glTable.set_function("viewport", [](int x, int y, int width, int height) {
-            Flux::GL::Viewport(x, y, width, height);
+            GLBackend::Get().Viewport(x, y, width, height);
         });
 
         glTable.set_function("create_vertex_buffer", [](sol::as_table_t<std::vector<float>> vertices, sol::optional<unsigned int> usage) {
             const auto data = vertices.value();
             return StoreBuffer(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size() * sizeof(float)), data.data(), usage.value_or(GL_STATIC_DRAW));
         });
-        glTable.set_function("create_index_buffer", [](sol::as_table_t<std::vector<unsigned int>> indices, sol::optional<unsigned int> usage) {
-            const auto data = indices.value();
-            return StoreBuffer(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size() * sizeof(unsigned int)), data.data(), usage.value_or(GL_STATIC_DRAW));
+        glTable.set_function("create_packed_vertex_buffer", [](sol::as_table_t<std::vector<float>> values, const sol::table& layout, int stride, sol::optional<unsigned int> usage) {
+            std::vector<uint8_t> packed;
+            std::string error;
+            if (!VertexPacking::Pack(values.value(), ReadPackedLayout(layout), stride, packed, error))
+                return std::make_tuple(-1, error);
+            return std::make_tuple(StoreBuffer(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.size()), packed.data(), usage.value_or(GL_STATIC_DRAW)), std::string{});
+        });
+        glTable.set_function("create_index_buffer", [](sol::as_table_t<std::vector<unsigned int>> indices, sol::optional<unsigned int> usage, sol::optional<unsigned int> type) {
+            const auto& data = indices.value();
+            // 32-bit unless asked otherwise, as before index types were tracked.
+            const GLenum indexType = type && type.value() != 0 ? type.value() : GL_UNSIGNED_INT;
+            return StoreIndexBuffer(data, indexType, usage.value_or(GL_STATIC_DRAW));
+        });
+        glTable.set_function("index_buffer_info", [](int handle) {
+            auto it = s_Buffers.find(handle);
+            if (it == s_Buffers.end() || it->second.target != GL_ELEMENT_ARRAY_BUFFER)
+                return std::make_tuple(0u, 0);
+            return std::make_tuple(static_cast<unsigned int>(it->second.indexType), static_cast<int>(it->second.indexCount));
         });
         glTable.set_function("delete_buffer", [](int handle) {
             auto it = s_Buffers.find(handle);
             if (it != s_Buffers.end()) {
-                Flux::GL::DeleteBuffer(it->second.id);
+                GLBackend::Get().DeleteObject(GLDeletionQueue::ObjectType::Buffer, it->second.id);
                 s_Buffers.erase(it);
             }
         });
         glTable.set_function("bind_buffer", [](int handle, sol::optional<unsigned int> targetOverride) {
             if (handle == 0) {
-                if (targetOverride)
-                    Flux::GL::BindBuffer(targetOverride.value(), 0);
+                if (targetOverride) {
+                    CountedGL::BindBuffer(targetOverride.value(), 0);
+                    if (targetOverride.value() == GL_ELEMENT_ARRAY_BUFFER)
+                        TrackElementBuffer(0);
+                }
                 return;
             }
             auto it = s_Buffers.find(handle);
-            if (it != s_Buffers.end())
-                Flux::GL::BindBuffer(targetOverride.value_or(it->second.target), it->second.id);
+            if (it == s_Buffers.end())
+                return;
+            const GLenum target = targetOverride.value_or(it->second.target);
+            CountedGL::BindBuffer(target, it->second.id);
+            if (target == GL_ELEMENT_ARRAY_BUFFER)
+                TrackElementBuffer(handle);
         });
         glTable.set_function("update_vertex_buffer", [](int handle, sol::as_table_t<std::vector<float>> vertices, sol::optional<unsigned int> usage) {
             auto it = s_Buffers.find(handle);
@@ -106,17 +929,39 @@ void Register(sol::state& lua) {
             const auto data = vertices.value();
             if (data.empty())
                 return false;
-            Flux::GL::UpdateBufferData(it->second.id, GL_ARRAY_BUFFER, static_cast<std::size_t>(data.size() * sizeof(float)), data.data(), usage.value_or(GL_DYNAMIC_DRAW));
+            CountedGL::UpdateBufferData(it->second.id, GL_ARRAY_BUFFER, static_cast<std::size_t>(data.size() * sizeof(float)), data.data(), usage.value_or(GL_DYNAMIC_DRAW));
             return true;
         });
-        glTable.set_function("update_index_buffer", [](int handle, sol::as_table_t<std::vector<unsigned int>> indices, sol::optional<unsigned int> usage) {
+        glTable.set_function("update_packed_vertex_buffer", [](int handle, sol::as_table_t<std::vector<float>> values, const sol::table& layout, int stride, sol::optional<unsigned int> usage) {
+            auto it = s_Buffers.find(handle);
+            if (it == s_Buffers.end() || it->second.target != GL_ARRAY_BUFFER)
+                return std::make_tuple(false, std::string("invalid vertex buffer handle"));
+            std::vector<uint8_t> packed;
+            std::string error;
+            if (!VertexPacking::Pack(values.value(), ReadPackedLayout(layout), stride, packed, error))
+                return std::make_tuple(false, error);
+            CountedGL::UpdateBufferData(it->second.id, GL_ARRAY_BUFFER, packed.size(), packed.data(), usage.value_or(GL_DYNAMIC_DRAW));
+            return std::make_tuple(true, std::string{});
+        });
+        glTable.set_function("update_index_buffer", [](int handle, sol::as_table_t<std::vector<unsigned int>> indices, sol::optional<unsigned int> usage, sol::optional<unsigned int> type) {
             auto it = s_Buffers.find(handle);
             if (it == s_Buffers.end() || it->second.target != GL_ELEMENT_ARRAY_BUFFER)
                 return false;
-            const auto data = indices.value();
+            const auto& data = indices.value();
             if (data.empty())
                 return false;
-            Flux::GL::UpdateBufferData(it->second.id, GL_ELEMENT_ARRAY_BUFFER, static_cast<std::size_t>(data.size() * sizeof(unsigned int)), data.data(), usage.value_or(GL_DYNAMIC_DRAW));
+            // Keep the current type while the new indices still fit in it.
+            GLenum indexType = type && type.value() != 0 ? type.value() : it->second.indexType;
+            std::vector<uint8_t> packed;
+            if (!PackIndices(data, indexType, packed)) {
+                if (type && type.value() != 0)
+                    return false;
+                indexType = InferIndexType(data);
+                PackIndices(data, indexType, packed);
+            }
+            CountedGL::UpdateBufferData(it->second.id, GL_ELEMENT_ARRAY_BUFFER, packed.size(), packed.data(), usage.value_or(GL_DYNAMIC_DRAW));
+            it->second.indexType = indexType;
+            it->second.indexCount = static_cast<GLsizei>(data.size());
             return true;
         });
 
@@ -125,50 +970,529 @@ void Register(sol::state& lua) {
         });
         glTable.set_function("bind_vertex_array", [](int handle) {
             auto it = s_VertexArrays.find(handle);
-            if (it != s_VertexArrays.end())
-                Flux::GL::BindVertexArray(it->second.id);
-            else
-                Flux::GL::BindVertexArray(0);
+            if (it != s_VertexArrays.end()) {
+                CountedGL::BindVertexArray(it->second.id);
+                s_BoundVertexArray = handle;
+            } else {
+                CountedGL::BindVertexArray(0);
+                s_BoundVertexArray = 0;
+            }
+        });
+        glTable.set_function("create_mesh", [](const sol::table& layout, int stride, sol::as_table_t<std::vector<float>> vertices, sol::optional<sol::table> indices, sol::optional<sol::table> options) {
+            MeshResource mesh;
+            mesh.formats = ReadPackedLayout(layout);
+            mesh.stride = stride;
+            for (std::size_t i = 1; i <= mesh.formats.size(); ++i) {
+                sol::table element = layout.get<sol::table>(i);
+                MeshAttributeBinding binding;
+                binding.location = element.get_or("index", static_cast<unsigned int>(i - 1));
+                binding.divisor = element.get_or("divisor", 0u);
+                mesh.bindings.push_back(binding);
+            }
+            GLenum indexType = 0;
+            if (options) {
+                mesh.usage = options->get_or("usage", static_cast<unsigned int>(GL_STATIC_DRAW));
+                mesh.mode = options->get_or("mode", static_cast<unsigned int>(GL_TRIANGLES));
+                indexType = options->get_or("index_type", 0u);
+            }
+
+            GLBackend& backend = GLBackend::Get();
+            mesh.vertexArray = backend.CreateVertexArray();
+            mesh.vertexBuffer = backend.CreateBufferName();
+            std::string error;
+            bool ok = UploadMeshVertices(mesh, vertices.value(), error);
+            if (ok && indices) {
+                const std::vector<unsigned int> indexData = ReadIndexTable(*indices);
+                mesh.indexBuffer = backend.CreateBufferName();
+                ok = UploadMeshIndices(mesh, indexData, indexType != 0 ? indexType : InferIndexType(indexData), error);
+            }
+            if (!ok) {
+                DeleteMeshObjects(mesh);
+                return std::make_tuple(-1, error);
+            }
+
+            SetupMeshVertexArray(mesh);
+            const int handle = s_NextHandle++;
+            s_Meshes[handle] = std::move(mesh);
+            return std::make_tuple(handle, std::string{});
+        });
+        glTable.set_function("update_mesh_vertices", [](int handle, sol::as_table_t<std::vector<float>> vertices) {
+            auto it = s_Meshes.find(handle);
+            if (it == s_Meshes.end())
+                return std::make_tuple(false, std::string("invalid mesh handle"));
+            std::string error;
+            const bool ok = UploadMeshVertices(it->second, vertices.value(), error);
+            return std::make_tuple(ok, error);
+        });
+        glTable.set_function("update_mesh_indices", [](int handle, const sol::table& indices, sol::optional<unsigned int> type) {
+            auto it = s_Meshes.find(handle);
+            if (it == s_Meshes.end())
+                return std::make_tuple(false, std::string("invalid mesh handle"));
+            MeshResource& mesh = it->second;
+            if (mesh.indexBuffer == 0)
+                return std::make_tuple(false, std::string("mesh was created without indices"));
+            const std::vector<unsigned int> indexData = ReadIndexTable(indices);
+            const GLenum indexType = type && type.value() != 0 ? type.value() : InferIndexType(indexData);
+            std::string error;
+            const bool ok = UploadMeshIndices(mesh, indexData, indexType, error);
+            return std::make_tuple(ok, error);
+        });
+        glTable.set_function("draw_mesh", [](int handle, sol::optional<int> instances, sol::optional<unsigned int> mode) {
+            auto it = s_Meshes.find(handle);
+            if (it == s_Meshes.end())
+                return false;
+            CountedGL::BindVertexArray(it->second.vertexArray);
+            s_BoundVertexArray = 0;
+            if (CanDraw())
+                DrawMeshResource(it->second, mode.value_or(it->second.mode), instances.value_or(1));
+            return true;
+        });
+        glTable.set_function("mesh_info", [](int handle) {
+            auto it = s_Meshes.find(handle);
+            if (it == s_Meshes.end())
+                return std::make_tuple(0, 0, 0u);
+            return std::make_tuple(static_cast<int>(it->second.vertexCount), static_cast<int>(it->second.indexCount),
+                static_cast<unsigned int>(it->second.indexType));
+        });
+        glTable.set_function("delete_mesh", [](int handle) {
+            auto it = s_Meshes.find(handle);
+            if (it == s_Meshes.end())
+                return;
+            DeleteMeshObjects(it->second);
+            s_Meshes.erase(it);
+        });
+
+        // Quad batches: state, quads and lines accumulate until flush, which
+        // sorts by layer, shader and texture and draws each run once.
+        glTable.set_function("create_quad_batch", []() {
+            const int handle = s_NextHandle++;
+            s_QuadBatches[handle] = std::make_unique<QuadBatch>();
+            return handle;
+        });
+        glTable.set_function("quad_batch_viewport", [](int handle, float width, float height) {
+            if (QuadBatch* batch = FindQuadBatch(handle))
+                batch->SetViewport(width, height);
+        });
+        glTable.set_function("quad_batch_state", [](int handle, sol::optional<int> shader, sol::optional<int> texture, sol::optional<int> layer) {
+            if (QuadBatch* batch = FindQuadBatch(handle))
+                batch->SetState(shader.value_or(0), texture.value_or(0), layer.value_or(0));
+        });
+        glTable.set_function("quad_batch_quad", [](int handle, float x, float y, float width, float height, sol::optional<sol::table> uv, sol::object color) {
+            QuadBatch* batch = FindQuadBatch(handle);
+            if (!batch)
+                return false;
+            float coords[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+            if (uv) {
+                for (int i = 0; i < 4; ++i)
+                    coords[i] = uv->get_or(i + 1, coords[i]);
+            }
+            batch->Quad(x, y, width, height, coords, ReadColor(color));
+            return true;
+        });
+        glTable.set_function("quad_batch_line", [](int handle, float x0, float y0, float x1, float y1, sol::optional<float> thickness, sol::object color) {
+            QuadBatch* batch = FindQuadBatch(handle);
+            if (!batch)
+                return false;
+            batch->Line(x0, y0, x1, y1, thickness.value_or(1.0f), ReadColor(color));
+            return true;
+        });
+        glTable.set_function("quad_batch_size", [](int handle) {
+            QuadBatch* batch = FindQuadBatch(handle);
+            return batch ? static_cast<int>(batch->GetQuadCount()) : 0;
+        });
+        glTable.set_function("quad_batch_clear", [](int handle) {
+            if (QuadBatch* batch = FindQuadBatch(handle))
+                batch->Clear();
+        });
+        glTable.set_function("quad_batch_flush", [](int handle) {
+            QuadBatch* batch = FindQuadBatch(handle);
+            return batch ? FlushQuadBatch(*batch) : 0;
+        });
+        glTable.set_function("delete_quad_batch", [](int handle) {
+            s_QuadBatches.erase(handle);
         });
         glTable.set_function("delete_vertex_array", [](int handle) {
             auto it = s_VertexArrays.find(handle);
             if (it != s_VertexArrays.end()) {
-                Flux::GL::DeleteVertexArray(it->second.id);
+                // Deleting a bound VAO would unbind it; keep that behaviour
+                // even though the name itself is only released later.
+                if (s_BoundVertexArray == handle) {
+                    CountedGL::BindVertexArray(0);
+                    s_BoundVertexArray = 0;
+                }
+                GLBackend::Get().DeleteObject(GLDeletionQueue::ObjectType::VertexArray, it->second.id);
                 s_VertexArrays.erase(it);
             }
         });
         glTable.set_function("enable_vertex_attrib_array", [](unsigned int index) {
-            Flux::GL::EnableVertexAttribArray(index);
+            GLBackend::Get().EnableVertexAttribArray(index);
         });
         glTable.set_function("vertex_attrib_pointer", [](unsigned int index, int size, unsigned int type, bool normalized, int stride, intptr_t offset) {
-            Flux::GL::VertexAttribPointer(index, size, type, normalized, stride, offset);
+            GLBackend::Get().VertexAttribPointer(index, size, type, normalized, stride, offset);
+        });
+        glTable.set_function("draw_elements", [](unsigned int mode, int count, sol::optional<unsigned int> type, sol::optional<intptr_t> offset) {
+            GLenum indexType = type.value_or(0);
+            ResolveIndexedDraw("draw_elements", count, indexType, offset.value_or(0));
+            if (CanDraw())
+                CountedGL::DrawElements(mode, count, indexType, offset.value_or(0));
+            return true;
+        });
+        glTable.set_function("draw_arrays", [](unsigned int mode, int first, int count) {
+            if (CanDraw())
+                CountedGL::DrawArrays(mode, first, count);
+        });
+        glTable.set_function("draw_elements_instanced", [](unsigned int mode, int count, unsigned int type, intptr_t offset, int instances) {
+            GLenum indexType = type;
+            ResolveIndexedDraw("draw_elements_instanced", count, indexType, offset);
+            if (CanDraw())
+                CountedGL::DrawElementsInstanced(mode, count, indexType, offset, instances);
+            return true;
+        });
+        glTable.set_function("draw_arrays_instanced", [](unsigned int mode, int first, int count, int instances) {
+            if (CanDraw())
+                CountedGL::DrawArraysInstanced(mode, first, count, instances);
+        });
+        glTable.set_function("vertex_attrib_divisor", [](unsigned int index, unsigned int divisor) {
+            GLBackend::Get().VertexAttribDivisor(index, divisor);
+        });
+        glTable.set_function("multi_draw_arrays", [](unsigned int mode, sol::as_table_t<std::vector<GLint>> firsts, sol::as_table_t<std::vector<GLsizei>> counts) {
+            if (CanDraw())
+                MultiDrawArrays(mode, firsts.value(), counts.value());
+        });
+        glTable.set_function("multi_draw_elements", [](unsigned int mode, sol::as_table_t<std::vector<GLsizei>> counts, unsigned int type, sol::as_table_t<std::vector<intptr_t>> offsets) {
+            if (CanDraw())
+                MultiDrawElements(mode, counts.value(), type, offsets.value());
+        });
+        glTable.set_function("stats", [](sol::this_state state) {
+            const GLFrameStats::Counters& stats = GLFrameStats::LastFrame();
+            sol::state_view lua(state);
+            sol::table result = lua.create_table();
+            result["draw_calls"] = stats.DrawCalls;
+            result["clears"] = stats.Clears;
+            result["shader_binds"] = stats.ShaderBinds;
+            result["vertex_array_binds"] = stats.VertexArrayBinds;
+            result["buffer_binds"] = stats.BufferBinds;
+            result["framebuffer_binds"] = stats.FramebufferBinds;
+            result["texture_binds"] = stats.TextureBinds;
+            result["uniform_updates"] = stats.UniformUpdates;
+            result["state_changes"] = stats.StateChanges();
+            result["buffer_uploads"] = stats.BufferUploads;
+            result["buffer_bytes"] = stats.BufferBytes;
+            result["texture_uploads"] = stats.TextureUploads;
+            result["texture_bytes"] = stats.TextureBytes;
+            result["readbacks"] = stats.Readbacks;
+            result["readback_bytes"] = stats.ReadbackBytes;
+            return result;
+        });
+        glTable.set_function("deletion_queue_size", []() {
+            return std::make_tuple(GLDeletionQueue::GetPendingObjectCount(), GLDeletionQueue::GetPendingBatchCount());
+        });
+        glTable.set_function("backend", []() {
+            return std::string(GLBackend::Get().GetName());
+        });
+        glTable.set_function("supports", [](const std::string& feature) {
+            if (feature == "instancing")
+                return SupportsFeature(GLBackend::Feature::Instancing);
+            if (feature == "multi_draw")
+                return SupportsFeature(GLBackend::Feature::MultiDraw);
+            if (feature == "indirect_draw")
+                return SupportsFeature(GLBackend::Feature::IndirectDraw);
+            if (feature == "multi_draw_indirect")
+                return SupportsFeature(GLBackend::Feature::MultiDrawIndirect);
+            if (feature == "timer_query")
+                return GLTimerQueries::IsAvailable();
+            if (feature == "etc2" || feature == "astc" || feature == "bc")
+                return TexturePool::SupportsCompressedFamily(feature);
+            return false;
+        });
+
+        // GPU timers: begin_timer/end_timer bracket a pass, timer_result returns
+        // smoothed CPU and GPU milliseconds (GPU is nil until a query finishes or
+        // when timer queries are unavailable).
+        glTable.set_function("begin_timer", [](const std::string& name) {
+            std::string error;
+            const bool ok = GLTimerQueries::Begin(name, error);
+            return std::make_tuple(ok, error);
+        });
+        glTable.set_function("end_timer", []() {
+            std::string error;
+            const bool ok = GLTimerQueries::End(error);
+            return std::make_tuple(ok, error);
+        });
+        glTable.set_function("timer_result", [](const std::string& name) {
+            const GLTimerQueries::Scope* scope = GLTimerQueries::FindScope(name);
+            sol::optional<double> cpuMs;
+            sol::optional<double> gpuMs;
+            if (scope && scope->Samples > 0)
+                cpuMs = scope->CpuMs;
+            if (scope && scope->HasGpuResult)
+                gpuMs = scope->GpuMs;
+            return std::make_tuple(cpuMs, gpuMs);
         });
-        glTable.set_function("draw_elements", [](unsigned int mode, int count, unsigned int type, intptr_t offset) {
-            Flux::GL::DrawElements(mode, count, type, offset);
+
+        // Indirect buffers hold tightly packed DrawArraysIndirectCommand (4 uints)
+        // or DrawElementsIndirectCommand (5 uints) records.
+        glTable.set_function("create_indirect_buffer", [](sol::as_table_t<std::vector<GLuint>> commands, sol::optional<unsigned int> usage) {
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+            if (!SupportsFeature(GLBackend::Feature::IndirectDraw))
+                return -1;
+            const auto& data = commands.value();
+            return StoreBuffer(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(data.size() * sizeof(GLuint)), data.data(), usage.value_or(GL_STATIC_DRAW));
+#else
+            (void)commands;
+            (void)usage;
+            return -1;
+#endif
+        });
+        glTable.set_function("draw_arrays_indirect", [](unsigned int mode, int buffer, sol::optional<intptr_t> offset) {
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+            if (!CanDraw() || !SupportsFeature(GLBackend::Feature::IndirectDraw) || !BindIndirectBuffer(buffer))
+                return false;
+            CountedGL::DrawArraysIndirect(mode, reinterpret_cast<const void*>(offset.value_or(0)));
+            return true;
+#else
+            (void)mode;
+            (void)buffer;
+            (void)offset;
+            return false;
+#endif
+        });
+        glTable.set_function("draw_elements_indirect", [](unsigned int mode, unsigned int type, int buffer, sol::optional<intptr_t> offset) {
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+            if (!CanDraw() || !SupportsFeature(GLBackend::Feature::IndirectDraw) || !BindIndirectBuffer(buffer))
+                return false;
+            CountedGL::DrawElementsIndirect(mode, type, reinterpret_cast<const void*>(offset.value_or(0)));
+            return true;
+#else
+            (void)mode;
+            (void)type;
+            (void)buffer;
+            (void)offset;
+            return false;
+#endif
+        });
+        glTable.set_function("multi_draw_arrays_indirect", [](unsigned int mode, int buffer, int drawCount, sol::optional<int> stride) {
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+            if (!CanDraw() || !SupportsFeature(GLBackend::Feature::IndirectDraw) || !BindIndirectBuffer(buffer))
+                return false;
+            const GLsizei recordStride = stride.value_or(0) > 0 ? stride.value() : static_cast<GLsizei>(4 * sizeof(GLuint));
+#if !defined(__ANDROID__)
+            if (SupportsFeature(GLBackend::Feature::MultiDrawIndirect)) {
+                CountedGL::MultiDrawArraysIndirect(mode, nullptr, drawCount, stride.value_or(0));
+                return true;
+            }
+#endif
+            for (int i = 0; i < drawCount; ++i)
+                CountedGL::DrawArraysIndirect(mode, reinterpret_cast<const void*>(static_cast<intptr_t>(i) * recordStride));
+            return true;
+#else
+            (void)mode;
+            (void)buffer;
+            (void)drawCount;
+            (void)stride;
+            return false;
+#endif
+        });
+        glTable.set_function("multi_draw_elements_indirect", [](unsigned int mode, unsigned int type, int buffer, int drawCount, sol::optional<int> stride) {
+#if defined(GL_DRAW_INDIRECT_BUFFER)
+            if (!CanDraw() || !SupportsFeature(GLBackend::Feature::IndirectDraw) || !BindIndirectBuffer(buffer))
+                return false;
+            const GLsizei recordStride = stride.value_or(0) > 0 ? stride.value() : static_cast<GLsizei>(5 * sizeof(GLuint));
+#if !defined(__ANDROID__)
+            if (SupportsFeature(GLBackend::Feature::MultiDrawIndirect)) {
+                CountedGL::MultiDrawElementsIndirect(mode, type, nullptr, drawCount, stride.value_or(0));
+                return true;
+            }
+#endif
+            for (int i = 0; i < drawCount; ++i)
+                CountedGL::DrawElementsIndirect(mode, type, reinterpret_cast<const void*>(static_cast<intptr_t>(i) * recordStride));
+            return true;
+#else
+            (void)mode;
+            (void)type;
+            (void)buffer;
+            (void)drawCount;
+            (void)stride;
+            return false;
+#endif
+        });
+
+        // Binds an image, render target or texture id to a texture unit; 0 unbinds.
+        glTable.set_function("bind_texture", [](int texture, sol::optional<unsigned int> unit) {
+            const GLuint id = (texture != 0 && s_TextureResolver) ? s_TextureResolver(texture) : 0;
+            CountedGL::BindTexture(unit.value_or(0), GL_TEXTURE_2D, id);
+            return texture == 0 || id != 0;
         });
 
         glTable.set_function("create_shader_program", [](const std::string& vertexSrc, const std::string& fragmentSrc) {
             return StoreShaderProgram(vertexSrc, fragmentSrc);
         });
-        glTable.set_function("use_shader_program", [](int handle) {
+        glTable.set_function("create_shader_program_async", [](const std::string& vertexSrc, const std::string& fragmentSrc, sol::optional<sol::protected_function> callback) {
+            return StorePendingShaderProgram(vertexSrc, fragmentSrc, callback.value_or(sol::protected_function{}));
+        });
+        glTable.set_function("shader_program_status", [](int handle) {
             auto it = s_Shaders.find(handle);
-            if (it != s_Shaders.end())
-                Flux::GL::UseProgram(it->second.program);
-            else
-                Flux::GL::UseProgram(0);
+            if (it == s_Shaders.end())
+                return std::make_tuple(std::string("invalid"), std::string{});
+            if (it->second.pending)
+                return std::make_tuple(std::string("pending"), std::string{});
+            if (it->second.failed)
+                return std::make_tuple(std::string("failed"), it->second.error);
+            return std::make_tuple(std::string("ready"), std::string{});
+        });
+        glTable.set_function("set_fallback_shader_program", [](int handle) {
+            s_FallbackShader = handle;
+        });
+        glTable.set_function("use_shader_program", [](int handle) {
+            CountedGL::UseProgram(ResolveProgram(handle));
         });
         glTable.set_function("delete_shader_program", [](int handle) {
+            auto pending = s_PendingShaders.find(handle);
+            if (pending != s_PendingShaders.end()) {
+                GLBackend::Get().CancelProgram(pending->second.program);
+                s_PendingShaders.erase(pending);
+            }
             auto it = s_Shaders.find(handle);
             if (it != s_Shaders.end()) {
-                Flux::GL::DeleteShaderProgram(it->second.program);
+                GLBackend::Get().DeleteObject(GLDeletionQueue::ObjectType::Program, it->second.program);
                 s_Shaders.erase(it);
             }
         });
         glTable.set_function("set_uniform_float", [](int handle, const std::string& name, float value) {
             auto it = s_Shaders.find(handle);
-            if (it == s_Shaders.end())
+            if (it == s_Shaders.end() || it->second.pending || it->second.failed)
+                return false;
+            return CountedGL::SetUniformFloat(it->second.program, name.c_str(), value);
+        });
+
+        glTable.set_function("create_command_list", []() {
+            return StoreCommandList();
+        });
+        glTable.set_function("delete_command_list", [](int handle) {
+            s_CommandLists.erase(handle);
+        });
+        glTable.set_function("reset_command_list", [](int handle) {
+            CommandListResource* list = FindCommandList(handle);
+            if (!list)
+                return false;
+            list->commands.clear();
+            return true;
+        });
+        glTable.set_function("command_list_size", [](int handle) {
+            CommandListResource* list = FindCommandList(handle);
+            return list ? static_cast<int>(list->commands.size()) : 0;
+        });
+        glTable.set_function("sort_command_list", [](int handle) {
+            CommandListResource* list = FindCommandList(handle);
+            if (!list)
                 return false;
-            return Flux::GL::SetUniformFloat(it->second.program, name.c_str(), value);
+            SortCommandList(*list);
+            return true;
+        });
+        glTable.set_function("execute_command_list", [](int handle) {
+            CommandListResource* list = FindCommandList(handle);
+            if (!list)
+                return false;
+            ExecuteCommandList(*list);
+            return true;
+        });
+        glTable.set_function("cmd_clear_color", [](int list, float r, float g, float b, float a) {
+            RecordedCommand command;
+            command.type = CommandType::ClearColor;
+            command.values[0] = r;
+            command.values[1] = g;
+            command.values[2] = b;
+            command.values[3] = a;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_clear", [](int list, unsigned int mask) {
+            RecordedCommand command;
+            command.type = CommandType::Clear;
+            command.target = mask;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_viewport", [](int list, int x, int y, int width, int height) {
+            RecordedCommand command;
+            command.type = CommandType::Viewport;
+            command.values[0] = static_cast<float>(x);
+            command.values[1] = static_cast<float>(y);
+            command.values[2] = static_cast<float>(width);
+            command.values[3] = static_cast<float>(height);
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_use_shader_program", [](int list, int shader) {
+            RecordedCommand command;
+            command.type = CommandType::UseShader;
+            command.handle = shader;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_bind_vertex_array", [](int list, int vertexArray) {
+            RecordedCommand command;
+            command.type = CommandType::BindVertexArray;
+            command.handle = vertexArray;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_bind_buffer", [](int list, int buffer, sol::optional<unsigned int> targetOverride) {
+            RecordedCommand command;
+            command.type = CommandType::BindBuffer;
+            command.handle = buffer;
+            command.target = targetOverride.value_or(0);
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_set_uniform_float", [](int list, int shader, const std::string& name, float value) {
+            auto it = s_Shaders.find(shader);
+            if (it == s_Shaders.end() || it->second.pending || it->second.failed)
+                return false;
+            RecordedCommand command;
+            command.type = CommandType::UniformFloat;
+            command.handle = shader;
+            command.location = GLBackend::Get().GetUniformLocation(it->second.program, name.c_str());
+            command.values[0] = value;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_draw_elements", [](int list, unsigned int mode, int count, sol::optional<unsigned int> type, intptr_t offset) {
+            RecordedCommand command;
+            command.type = CommandType::DrawElements;
+            command.target = mode;
+            command.count = count;
+            command.indexType = type.value_or(0);
+            command.offset = offset;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_draw_arrays", [](int list, unsigned int mode, int first, int count) {
+            RecordedCommand command;
+            command.type = CommandType::DrawArrays;
+            command.target = mode;
+            command.first = first;
+            command.count = count;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_draw_elements_instanced", [](int list, unsigned int mode, int count, sol::optional<unsigned int> type, intptr_t offset, int instances) {
+            RecordedCommand command;
+            command.type = CommandType::DrawElementsInstanced;
+            command.target = mode;
+            command.count = count;
+            command.indexType = type.value_or(0);
+            command.offset = offset;
+            command.instances = instances;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_draw_arrays_instanced", [](int list, unsigned int mode, int first, int count, int instances) {
+            RecordedCommand command;
+            command.type = CommandType::DrawArraysInstanced;
+            command.target = mode;
+            command.first = first;
+            command.count = count;
+            command.instances = instances;
+            return RecordCommand(list, command);
+        });
+        glTable.set_function("cmd_draw_mesh", [](int list, int mesh, sol::optional<int> instances, sol::optional<unsigned int> mode) {
+            RecordedCommand command;
+            command.type = CommandType::DrawMesh;
+            command.handle = mesh;
+            command.target = mode.value_or(0);
+            command.instances = instances.value_or(1);
+            return RecordCommand(list, command);
         });
     };
 
@@ -176,4 +1500,89 @@ void Register(sol::state& lua) {
     registerCommon("opengles");
 }
 
+std::vector<std::string> PollPendingShaders() {
+    std::vector<std::string> messages;
+    const bool parallel = SupportsFeature(GLBackend::Feature::ParallelShaderCompile);
+    // Without parallel compilation, finish at most one program per frame.
+    int blockingBudget = 1;
+
+    struct FinishedShader {
+        int handle;
+        bool ready;
+        std::string error;
+        sol::protected_function callback;
+    };
+    // Callbacks run after the scan: they may create or delete shaders, which
+    // would invalidate the iterator.
+    std::vector<FinishedShader> finished;
+
+    for (auto it = s_PendingShaders.begin(); it != s_PendingShaders.end();) {
+        const bool allowBlocking = !parallel && blockingBudget > 0;
+        std::string error;
+        const ShaderProgramCache::ProgramStatus status = GLBackend::Get().PollProgram(it->second.program, allowBlocking, error);
+        if (status == ShaderProgramCache::ProgramStatus::Pending) {
+            ++it;
+            continue;
+        }
+        if (allowBlocking)
+            --blockingBudget;
+
+        const int handle = it->first;
+        const bool ready = status == ShaderProgramCache::ProgramStatus::Ready;
+        ShaderResource& resource = s_Shaders[handle];
+        resource.pending = false;
+        resource.failed = !ready;
+        resource.program = ready ? it->second.program.Program : 0;
+        resource.error = error;
+
+        finished.push_back({ handle, ready, std::move(error), std::move(it->second.callback) });
+        it = s_PendingShaders.erase(it);
+    }
+
+    for (FinishedShader& shader : finished) {
+        if (shader.callback.valid()) {
+            sol::protected_function_result result = shader.callback(shader.handle, shader.ready, shader.error);
+            if (!result.valid()) {
+                sol::error err = result;
+                messages.push_back(std::string("[Error] shader callback: ") + err.what());
+            }
+        } else if (!shader.ready) {
+            messages.push_back("[Error] Shader program " + std::to_string(shader.handle) + " failed: " + shader.error);
+        }
+    }
+    return messages;
+}
+
+void BeginFrame() {
+    // The host draws between frames, so the tracked bindings are stale.
+    s_BoundProgram = 0;
+    s_BoundTexture0 = 0;
+    GLFrameStats::BeginFrame();
+    GLTimerQueries::BeginFrame();
+    GLDeletionQueue::BeginFrame();
+}
+
+void SetTextureResolver(std::function<GLuint(int)> resolver) {
+    s_TextureResolver = std::move(resolver);
+}
+
+void ReleaseScriptReferences() {
+    for (auto& entry : s_PendingShaders)
+        entry.second.callback = sol::protected_function{};
+}
+
+void ReleaseAll() {
+    for (const auto& entry : s_Meshes)
+        DeleteMeshObjects(entry.second);
+    s_Meshes.clear();
+    s_CommandLists.clear();
+    s_FallbackShader = 0;
+    s_SkipDraws = false;
+    s_QuadBatches.clear();
+    if (s_WhiteTexture != 0) {
+        GLBackend::Get().DeleteObject(GLDeletionQueue::ObjectType::Texture, s_WhiteTexture);
+        s_WhiteTexture = 0;
+    }
+}
+
 } // namespace LuaGLBindings
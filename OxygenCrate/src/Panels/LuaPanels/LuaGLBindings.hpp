@@ -1,7 +1,26 @@
 #pragma once
 
+#include "GLWrappers.hpp"
 #include <sol/sol.hpp>
+#include <functional>
+#include <string>
+#include <vector>
 
 namespace LuaGLBindings {
     void Register(sol::state& lua);
+    // Frame-start bookkeeping: retires deferred GL deletions whose fences
+    // have signalled. Call before any script rendering.
+    void BeginFrame();
+    // Advances asynchronous shader programs and runs their Lua callbacks.
+    // Returns console messages for failures. Call once per frame.
+    std::vector<std::string> PollPendingShaders();
+    // Maps texture ids used by scripts (images, render targets, textures) to GL texture
+    // names for the quad batcher. Returning 0 falls back to a white texture.
+    void SetTextureResolver(std::function<GLuint(int)> resolver);
+    // Drops Lua references held by the bindings; call before the state is destroyed.
+    void ReleaseScriptReferences();
+    // Frees meshes, command lists, quad batches and the fallback white texture
+    // and forgets the fallback shader; call when the script that used them is
+    // torn down, before the deletion queue is flushed.
+    void ReleaseAll();
 }
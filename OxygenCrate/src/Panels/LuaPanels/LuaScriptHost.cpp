@@ -1,6 +1,13 @@
 #include "LuaScriptHost.hpp"
 #include "../../external/Flux/Flux/Core/src/Image.hpp"
 #include "LuaGLBindings.hpp"
+#include "ShaderProgramCache.hpp"
+#include "RenderTargetPool.hpp"
+#include "PixelReadback.hpp"
+#include "TexturePool.hpp"
+#include "GLDeletionQueue.hpp"
+#include "GLFrameStats.hpp"
+#include "GLTimerQueries.hpp"
 #include "GLWrappers.hpp"
 #include <imgui_internal.h>
 #include <imgui.h>
@@ -34,6 +41,70 @@ extern android_app* g_AndroidApp;
 namespace {
 constexpr const char* kSampleScriptFileName = "Sample.lua";
 constexpr const char* kVec2ModuleName = "Vec2.lua";
+
+GLenum ParseTextureFilter(const std::string& name, GLenum fallback)
+{
+    if (name == "nearest")
+        return GL_NEAREST;
+    if (name == "linear")
+        return GL_LINEAR;
+    if (name == "nearest_mipmap_nearest")
+        return GL_NEAREST_MIPMAP_NEAREST;
+    if (name == "linear_mipmap_nearest")
+        return GL_LINEAR_MIPMAP_NEAREST;
+    if (name == "nearest_mipmap_linear")
+        return GL_NEAREST_MIPMAP_LINEAR;
+    if (name == "linear_mipmap_linear")
+        return GL_LINEAR_MIPMAP_LINEAR;
+    return fallback;
+}
+
+GLenum ParseTextureWrap(const std::string& name, GLenum fallback)
+{
+    if (name == "clamp")
+        return GL_CLAMP_TO_EDGE;
+    if (name == "repeat")
+        return GL_REPEAT;
+    if (name == "mirror")
+        return GL_MIRRORED_REPEAT;
+    return fallback;
+}
+
+// Options: filter/min_filter/mag_filter, wrap/wrap_s/wrap_t and mipmaps.
+// Mipmapped textures default to trilinear minification.
+TextureSampling ReadTextureSampling(const sol::optional<sol::table>& options, TextureSampling sampling = {})
+{
+    if (!options)
+        return sampling;
+    const sol::table& table = *options;
+    const sol::optional<bool> mipmaps = table.get<sol::optional<bool>>("mipmaps");
+    if (mipmaps)
+    {
+        sampling.Mipmaps = *mipmaps;
+        if (sampling.Mipmaps && sampling.MinFilter == GL_LINEAR)
+            sampling.MinFilter = GL_LINEAR_MIPMAP_LINEAR;
+    }
+
+    const std::string filter = table.get_or("filter", std::string{});
+    if (!filter.empty())
+    {
+        const GLenum base = ParseTextureFilter(filter, GL_LINEAR);
+        sampling.MagFilter = base;
+        if (sampling.Mipmaps)
+            sampling.MinFilter = base == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+        else
+            sampling.MinFilter = base;
+    }
+    sampling.MinFilter = ParseTextureFilter(table.get_or("min_filter", std::string{}), sampling.MinFilter);
+    sampling.MagFilter = ParseTextureFilter(table.get_or("mag_filter", std::string{}), sampling.MagFilter);
+
+    const std::string wrap = table.get_or("wrap", std::string{});
+    sampling.WrapS = ParseTextureWrap(wrap, sampling.WrapS);
+    sampling.WrapT = ParseTextureWrap(wrap, sampling.WrapT);
+    sampling.WrapS = ParseTextureWrap(table.get_or("wrap_s", std::string{}), sampling.WrapS);
+    sampling.WrapT = ParseTextureWrap(table.get_or("wrap_t", std::string{}), sampling.WrapT);
+    return sampling;
+}
 }
 
 #ifdef __ANDROID__
@@ -217,10 +288,18 @@ constexpr LuaAssetFile kLuaAssetFiles[] = {
     { "lua/modules/IndexBuffer.lua", "modules/IndexBuffer.lua" },
     { "lua/modules/BufferLayout.lua", "modules/BufferLayout.lua" },
     { "lua/modules/Shader.lua", "modules/Shader.lua" },
+    { "lua/modules/CommandList.lua", "modules/CommandList.lua" },
+    { "lua/modules/Mesh.lua", "modules/Mesh.lua" },
+    { "lua/modules/QuadBatch.lua", "modules/QuadBatch.lua" },
+    { "lua/modules/Texture.lua", "modules/Texture.lua" },
     { "lua/shaders/opengl/simple.vert", "shaders/opengl/simple.vert" },
     { "lua/shaders/opengl/simple.frag", "shaders/opengl/simple.frag" },
+    { "lua/shaders/opengl/quad_batch.vert", "shaders/opengl/quad_batch.vert" },
+    { "lua/shaders/opengl/quad_batch.frag", "shaders/opengl/quad_batch.frag" },
     { "lua/shaders/opengles/simple.vert", "shaders/opengles/simple.vert" },
     { "lua/shaders/opengles/simple.frag", "shaders/opengles/simple.frag" },
+    { "lua/shaders/opengles/quad_batch.vert", "shaders/opengles/quad_batch.vert" },
+    { "lua/shaders/opengles/quad_batch.frag", "shaders/opengles/quad_batch.frag" },
 };
 
 std::filesystem::path LuaScriptHost::GetModuleDirectory()
@@ -240,6 +319,24 @@ std::filesystem::path LuaScriptHost::GetModuleDirectory()
 #endif
 }
 
+std::filesystem::path LuaScriptHost::GetCacheDirectory()
+{
+#ifdef __ANDROID__
+    if (g_AndroidApp && g_AndroidApp->activity && g_AndroidApp->activity->internalDataPath)
+    {
+        std::filesystem::path internal = std::filesystem::path(g_AndroidApp->activity->internalDataPath) / "cache";
+        if (CanWriteToDirectory(internal))
+            return internal;
+    }
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "OxygenCrateCache";
+#else
+    std::filesystem::path dir = GetExecutableDirectory() / "cache";
+#endif
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
 static std::filesystem::path GetSampleScriptPath()
 {
     return LuaScriptHost::GetModuleDirectory() / kSampleScriptFileName;
@@ -294,6 +391,8 @@ void LuaScriptHost::EnsureDefaultModulesInstalled()
 LuaScriptHost::LuaScriptHost()
 {
     EnsureDefaultModulesInstalled();
+    ShaderProgramCache::SetDirectory(GetCacheDirectory() / "shaders");
+    LuaGLBindings::SetTextureResolver([this](int imageId) { return GetImageTexture(imageId); });
     std::string sample = ReadTextFile(GetSampleScriptPath());
     if (sample.empty())
     {
@@ -314,17 +413,69 @@ LuaScriptHost::LuaScriptHost()
     AppendConsoleLine("Load or type a Lua script, then press \"Run Lua Script\".");
 }
 
+LuaScriptHost::~LuaScriptHost()
+{
+    LuaGLBindings::SetTextureResolver(nullptr);
+    LuaGLBindings::ReleaseScriptReferences();
+    m_ReadbackCallbacks.clear();
+    m_RenderTargets.ReleaseAll();
+    m_Textures.ReleaseAll();
+    LuaGLBindings::ReleaseAll();
+    m_Readbacks.Clear();
+    GLTimerQueries::Reset();
+    GLDeletionQueue::Flush();
+}
+
+namespace {
+// lua_Reader adapter over a ScriptReader. The first chunk is fetched before
+// loading so an empty script can be reported without touching the Lua state.
+struct ScriptChunkReader
+{
+    const LuaScriptHost::ScriptReader* Source = nullptr;
+    std::array<char, 16 * 1024> Buffer;
+    size_t Pending = 0;
+
+    static const char* Read(lua_State*, void* data, size_t* size)
+    {
+        auto* self = static_cast<ScriptChunkReader*>(data);
+        *size = self->Pending != 0 ? self->Pending : (*self->Source)(self->Buffer.data(), self->Buffer.size());
+        self->Pending = 0;
+        return *size != 0 ? self->Buffer.data() : nullptr;
+    }
+};
+}
+
 bool LuaScriptHost::CompileScript(const std::string& script)
+{
+    size_t offset = 0;
+    return CompileScript([&script, &offset](char* buffer, size_t size)
+    {
+        const size_t count = std::min(size, script.size() - offset);
+        std::copy_n(script.data() + offset, count, buffer);
+        offset += count;
+        return count;
+    });
+}
+
+bool LuaScriptHost::CompileScript(const ScriptReader& reader)
 {
     m_LuaError.clear();
     m_LuaDrawFunction = sol::protected_function{};
     m_LuaRenderFunction = sol::protected_function{};
     m_IsScriptReady = false;
     m_LuaImages.clear();
+    m_RenderTargets.ReleaseAll();
+    m_Textures.ReleaseAll();
+    LuaGLBindings::ReleaseAll();
+    m_Readbacks.Clear();
+    GLTimerQueries::Reset();
     m_ImageScratchBuffer.clear();
     m_NextImageId = 1;
 
-    if (script.empty())
+    ScriptChunkReader chunkReader;
+    chunkReader.Source = &reader;
+    chunkReader.Pending = reader(chunkReader.Buffer.data(), chunkReader.Buffer.size());
+    if (chunkReader.Pending == 0)
     {
         m_LuaError = "Script editor is empty. Load the sample or write your own Lua code.";
         AppendConsoleLine(std::string("[Error] ") + m_LuaError);
@@ -333,6 +484,8 @@ bool LuaScriptHost::CompileScript(const std::string& script)
 
     try
     {
+        LuaGLBindings::ReleaseScriptReferences();
+        m_ReadbackCallbacks.clear();
         m_LuaState = sol::state{};
         m_LuaState.open_libraries(sol::lib::base,
             sol::lib::math,
@@ -418,12 +571,17 @@ bool LuaScriptHost::CompileScript(const std::string& script)
         });
         imguiTable.set_function("image", [this](int imageId, float width, float height)
         {
-            Flux::Image* image = GetLuaImage(imageId);
-            if (!image)
+            const GLuint texture = GetImageTexture(imageId);
+            if (texture == 0)
                 return;
-            ImTextureID textureID = static_cast<ImTextureID>(static_cast<uintptr_t>(image->GetColorAttachment()));
+            ImTextureID textureID = static_cast<ImTextureID>(static_cast<uintptr_t>(texture));
             ImGui::Image(textureID, ImVec2(width, height));
         });
+        imguiTable.set_function("get_content_region_avail", []()
+        {
+            const ImVec2 available = ImGui::GetContentRegionAvail();
+            return std::make_tuple(available.x, available.y);
+        });
         m_LuaState.create_named_table("opengl");
         m_LuaState.create_named_table("opengles");
         LuaGLBindings::Register(m_LuaState);
@@ -466,6 +624,112 @@ bool LuaScriptHost::CompileScript(const std::string& script)
                 AppendConsoleLine("[Error] Failed to create image");
             return handle;
         });
+        m_LuaState.set_function("create_render_target", [this](uint32_t width, uint32_t height, sol::optional<sol::table> options)
+        {
+            RenderTargetDesc desc;
+            desc.Width = width;
+            desc.Height = height;
+            if (options)
+            {
+                desc.Depth = options->get_or("depth", false);
+                desc.Stencil = options->get_or("stencil", false);
+                desc.Samples = options->get_or("samples", 1);
+                desc.ColorFormat = options->get_or("format", static_cast<unsigned int>(GL_RGBA8));
+            }
+            const int handle = m_NextImageId++;
+            if (!m_RenderTargets.Create(handle, desc))
+            {
+                AppendConsoleLine("[Error] Failed to create render target");
+                return -1;
+            }
+            return handle;
+        });
+        m_LuaState.set_function("resize_render_target", [this](int targetId, uint32_t width, uint32_t height)
+        {
+            return m_RenderTargets.Resize(targetId, width, height);
+        });
+        m_LuaState.set_function("release_render_target", [this](int targetId)
+        {
+            m_RenderTargets.Release(targetId);
+        });
+        m_LuaState.set_function("resolve_render_target", [this](int targetId)
+        {
+            m_RenderTargets.Resolve(targetId);
+        });
+        m_LuaState.set_function("render_target_size", [this](int targetId)
+        {
+            const RenderTargetDesc* desc = m_RenderTargets.GetDesc(targetId);
+            if (!desc)
+                return std::make_tuple(0u, 0u);
+            return std::make_tuple(desc->Width, desc->Height);
+        });
+        m_LuaState.set_function("create_texture", [this](uint32_t width, uint32_t height, sol::object pixels, sol::optional<sol::table> options)
+        {
+            // pixels: nil, a binary string or a table of RGBA8 bytes.
+            std::vector<uint8_t> data;
+            if (pixels.is<std::string>())
+            {
+                const std::string bytes = pixels.as<std::string>();
+                data.assign(bytes.begin(), bytes.end());
+            }
+            else if (pixels.is<sol::table>())
+            {
+                data = pixels.as<std::vector<uint8_t>>();
+            }
+            const size_t required = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+            if (!data.empty() && data.size() != required)
+            {
+                AppendConsoleLine("[Error] create_texture: pixel buffer does not match texture size");
+                return -1;
+            }
+
+            std::string error;
+            const int handle = m_NextImageId++;
+            if (!m_Textures.CreateRGBA8(handle, width, height, data.empty() ? nullptr : data.data(), ReadTextureSampling(options), error))
+            {
+                AppendConsoleLine("[Error] create_texture: " + error);
+                return -1;
+            }
+            return handle;
+        });
+        m_LuaState.set_function("load_texture", [this](const std::string& relativePath, sol::optional<sol::table> options)
+        {
+            std::string error;
+            const std::string bytes = ReadModuleFile(relativePath, error);
+            if (!error.empty())
+                return std::make_tuple(-1, error);
+
+            const int handle = m_NextImageId++;
+            if (!m_Textures.CreateFromKtx(handle, bytes, ReadTextureSampling(options), error))
+                return std::make_tuple(-1, relativePath + ": " + error);
+            return std::make_tuple(handle, std::string{});
+        });
+        m_LuaState.set_function("set_texture_sampling", [this](int textureId, sol::table options)
+        {
+            const TextureInfo* info = m_Textures.GetInfo(textureId);
+            if (!info)
+                return false;
+            return m_Textures.SetSampling(textureId, ReadTextureSampling(options, info->Sampling));
+        });
+        m_LuaState.set_function("texture_info", [this](int textureId, sol::this_state state)
+        {
+            const TextureInfo* info = m_Textures.GetInfo(textureId);
+            if (!info)
+                return sol::object(sol::lua_nil);
+            sol::state_view lua(state);
+            sol::table result = lua.create_table();
+            result["width"] = info->Width;
+            result["height"] = info->Height;
+            result["format"] = info->InternalFormat;
+            result["levels"] = info->Levels;
+            result["compressed"] = info->Compressed;
+            result["bytes"] = info->Bytes;
+            return sol::object(result);
+        });
+        m_LuaState.set_function("release_texture", [this](int textureId)
+        {
+            m_Textures.Release(textureId);
+        });
         m_LuaState.set_function("set_image_data", [this](int imageId, sol::as_table_t<std::vector<uint8_t>> pixelData)
         {
             Flux::Image* image = GetLuaImage(imageId);
@@ -482,47 +746,27 @@ bool LuaScriptHost::CompileScript(const std::string& script)
                 value = static_cast<uint8_t>(std::clamp<int>(value, 0, 255));
             m_ImageScratchBuffer = std::move(data);
             image->SetData(m_ImageScratchBuffer.data());
+            GLFrameStats::Counters& stats = GLFrameStats::Current();
+            ++stats.TextureUploads;
+            stats.TextureBytes += required;
             return true;
         });
         m_LuaState.set_function("load_module_file", [this](const std::string& relativePath)
         {
-            if (relativePath.empty())
-            {
-                AppendConsoleLine("[Error] load_module_file: empty path");
-                return std::string{};
-            }
-
-            std::filesystem::path relPath(relativePath);
-            if (relPath.is_absolute())
-            {
-                AppendConsoleLine("[Error] load_module_file: absolute paths are not allowed");
-                return std::string{};
-            }
-
-            std::filesystem::path normalized;
-            for (const auto& part : relPath)
-            {
-                if (part == "..")
-                {
-                    AppendConsoleLine("[Error] load_module_file: '..' segments are not allowed");
-                    return std::string{};
-                }
-                if (part == ".")
-                    continue;
-                normalized /= part;
-            }
-
-            const std::filesystem::path fullPath = GetModuleDirectory() / normalized;
-            std::string contents = ReadTextFile(fullPath);
-            if (contents.empty())
-            {
-                AppendConsoleLine("[Error] load_module_file: failed to read " + normalized.string());
-            }
+            std::string error;
+            std::string contents = ReadModuleFile(relativePath, error);
+            if (!error.empty())
+                AppendConsoleLine("[Error] load_module_file: " + error);
             return contents;
         });
         sol::table fluxImageTable = m_LuaState.create_named_table("flux_image");
         fluxImageTable.set_function("bind_framebuffer", [this](int imageId)
         {
+            if (m_RenderTargets.Bind(imageId))
+            {
+                ++GLFrameStats::Current().FramebufferBinds;
+                return true;
+            }
             Flux::Image* image = GetLuaImage(imageId);
             if (!image)
             {
@@ -530,15 +774,98 @@ bool LuaScriptHost::CompileScript(const std::string& script)
                 return false;
             }
             Flux::GL::BindFramebuffer(GL_FRAMEBUFFER, image->GetFramebuffer());
+            ++GLFrameStats::Current().FramebufferBinds;
             return true;
         });
         fluxImageTable.set_function("unbind_framebuffer", []()
         {
             Flux::GL::BindFramebuffer(GL_FRAMEBUFFER, 0);
+            ++GLFrameStats::Current().FramebufferBinds;
+        });
+        fluxImageTable.set_function("read_pixels_async", [this](int imageId, sol::optional<sol::table> rect, sol::optional<sol::protected_function> callback)
+        {
+            GLuint framebuffer = 0;
+            int imageWidth = 0;
+            int imageHeight = 0;
+            if (const RenderTargetDesc* desc = m_RenderTargets.GetDesc(imageId))
+            {
+                m_RenderTargets.Resolve(imageId);
+                framebuffer = m_RenderTargets.GetResolveFramebuffer(imageId);
+                imageWidth = static_cast<int>(desc->Width);
+                imageHeight = static_cast<int>(desc->Height);
+            }
+            else if (Flux::Image* image = GetLuaImage(imageId))
+            {
+                framebuffer = image->GetFramebuffer();
+                imageWidth = static_cast<int>(image->GetWidth());
+                imageHeight = static_cast<int>(image->GetHeight());
+            }
+            else
+            {
+                AppendConsoleLine("[Error] flux_image.read_pixels_async: invalid image handle");
+                return -1;
+            }
+
+            int x = 0;
+            int y = 0;
+            int width = imageWidth;
+            int height = imageHeight;
+            if (rect)
+            {
+                x = std::clamp(rect->get_or("x", 0), 0, imageWidth);
+                y = std::clamp(rect->get_or("y", 0), 0, imageHeight);
+                width = std::clamp(rect->get_or("width", imageWidth - x), 0, imageWidth - x);
+                height = std::clamp(rect->get_or("height", imageHeight - y), 0, imageHeight - y);
+            }
+            const int handle = m_Readbacks.Request(framebuffer, x, y, width, height);
+            if (handle >= 0)
+            {
+                GLFrameStats::Counters& stats = GLFrameStats::Current();
+                ++stats.Readbacks;
+                stats.ReadbackBytes += static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;
+            }
+            if (handle >= 0 && callback && callback->valid())
+                m_ReadbackCallbacks[handle] = *callback;
+            return handle;
+        });
+        fluxImageTable.set_function("readback_status", [this](int handle, sol::this_state state)
+        {
+            switch (m_Readbacks.GetStatus(handle))
+            {
+            case PixelReadback::Status::Pending:
+                return std::make_tuple(std::string("pending"), sol::object{});
+            case PixelReadback::Status::Ready:
+                return std::make_tuple(std::string("ready"), sol::object{});
+            case PixelReadback::Status::Failed:
+                return std::make_tuple(std::string("failed"), sol::make_object(state.lua_state(), *m_Readbacks.GetError(handle)));
+            default:
+                return std::make_tuple(std::string("invalid"), sol::object{});
+            }
+        });
+        fluxImageTable.set_function("readback_data", [this](int handle, sol::this_state state)
+        {
+            int width = 0;
+            int height = 0;
+            const std::string* data = m_Readbacks.GetStatus(handle) == PixelReadback::Status::Ready ? m_Readbacks.GetData(handle) : nullptr;
+            if (!data || !m_Readbacks.GetSize(handle, width, height))
+                return std::make_tuple(sol::object{}, 0, 0);
+            return std::make_tuple(sol::make_object(state.lua_state(), *data), width, height);
+        });
+        fluxImageTable.set_function("release_readback", [this](int handle)
+        {
+            m_Readbacks.Release(handle);
+            m_ReadbackCallbacks.erase(handle);
         });
 
         AppendConsoleLine("Running Lua script...");
-        sol::protected_function_result result = m_LuaState.safe_script(script, sol::script_pass_on_error);
+        sol::load_result chunk = m_LuaState.load(&ScriptChunkReader::Read, &chunkReader, "=script", sol::load_mode::text);
+        if (!chunk.valid())
+        {
+            sol::error err = chunk;
+            throw std::runtime_error(err.what());
+        }
+        sol::protected_function scriptFunction = chunk;
+        sol::protected_function_result result = scriptFunction();
         if (!result.valid())
         {
             sol::error err = result;
@@ -619,6 +946,10 @@ void LuaScriptHost::Draw()
 
 void LuaScriptHost::Render(float deltaTime)
 {
+    for (const std::string& message : LuaGLBindings::PollPendingShaders())
+        AppendConsoleLine(message);
+    PollReadbacks();
+
     if (!m_LuaRenderFunction.valid())
         return;
 
@@ -635,6 +966,26 @@ void LuaScriptHost::Render(float deltaTime)
     }
 }
 
+void LuaScriptHost::PollReadbacks()
+{
+    for (int handle : m_Readbacks.Poll())
+    {
+        if (const std::string* error = m_Readbacks.GetError(handle))
+            AppendConsoleLine("[Error] Readback " + std::to_string(handle) + " failed: " + *error);
+        auto it = m_ReadbackCallbacks.find(handle);
+        if (it == m_ReadbackCallbacks.end())
+            continue;
+        sol::protected_function callback = std::move(it->second);
+        m_ReadbackCallbacks.erase(it);
+        sol::protected_function_result callResult = callback(handle);
+        if (!callResult.valid())
+        {
+            sol::error err = callResult;
+            AppendConsoleLine(std::string("[Error] read_pixels_async callback: ") + err.what());
+        }
+    }
+}
+
 void LuaScriptHost::ClearConsole()
 {
     m_LuaConsoleLines.clear();
@@ -711,3 +1062,46 @@ Flux::Image* LuaScriptHost::GetLuaImage(int imageId)
         return nullptr;
     return it->second.get();
 }
+
+GLuint LuaScriptHost::GetImageTexture(int imageId)
+{
+    if (Flux::Image* image = GetLuaImage(imageId))
+        return image->GetColorAttachment();
+    if (const GLuint texture = m_Textures.GetTexture(imageId))
+        return texture;
+    return m_RenderTargets.GetColorTexture(imageId);
+}
+
+std::string LuaScriptHost::ReadModuleFile(const std::string& relativePath, std::string& error)
+{
+    if (relativePath.empty())
+    {
+        error = "empty path";
+        return {};
+    }
+
+    std::filesystem::path relPath(relativePath);
+    if (relPath.is_absolute())
+    {
+        error = "absolute paths are not allowed";
+        return {};
+    }
+
+    std::filesystem::path normalized;
+    for (const auto& part : relPath)
+    {
+        if (part == "..")
+        {
+            error = "'..' segments are not allowed";
+            return {};
+        }
+        if (part == ".")
+            continue;
+        normalized /= part;
+    }
+
+    std::string contents = ReadTextFile(GetModuleDirectory() / normalized);
+    if (contents.empty())
+        error = "failed to read " + normalized.string();
+    return contents;
+}
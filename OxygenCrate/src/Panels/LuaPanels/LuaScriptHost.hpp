@@ -3,8 +3,12 @@
 #include <sol/sol.hpp>
 #include "../../external/Flux/Flux/Core/src/Image.hpp"
 #include "LuaGLBindings.hpp"
+#include "RenderTargetPool.hpp"
+#include "PixelReadback.hpp"
+#include "TexturePool.hpp"
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -15,8 +19,15 @@ namespace Flux { class Image; }
 class LuaScriptHost {
 public:
     LuaScriptHost();
+    ~LuaScriptHost();
+
+    // Fills buffer with the next part of a script and returns the byte count,
+    // 0 once the script is exhausted.
+    using ScriptReader = std::function<size_t(char* buffer, size_t size)>;
 
     bool CompileScript(const std::string& script);
+    // Feeds the chunks straight into lua_load; the script is never held in one piece.
+    bool CompileScript(const ScriptReader& reader);
     void Draw();
     void Render(float deltaTime);
     void ClearConsole();
@@ -31,12 +42,19 @@ public:
     const std::string& GetSampleScript() const { return m_SampleScript; }
     bool IsReady() const { return m_IsScriptReady; }
     static std::filesystem::path GetModuleDirectory();
+    static std::filesystem::path GetCacheDirectory();
     static void EnsureDefaultModulesInstalled();
 
 private:
     void AppendConsoleLine(const std::string& line);
+    void PollReadbacks();
     int CreateLuaImage(uint32_t width, uint32_t height);
     Flux::Image* GetLuaImage(int imageId);
+    // Color texture of a Lua image, render target or texture, 0 when the id is unknown.
+    GLuint GetImageTexture(int imageId);
+    // Reads a file below the module directory. Absolute paths and '..'
+    // segments are rejected; returns empty contents and fills error on failure.
+    std::string ReadModuleFile(const std::string& relativePath, std::string& error);
 
     sol::state m_LuaState;
     sol::protected_function m_LuaDrawFunction;
@@ -48,6 +66,11 @@ private:
     std::string m_SampleScript;
     bool m_IsScriptReady = false;
     std::unordered_map<int, std::unique_ptr<Flux::Image>> m_LuaImages;
+    // Shares the image id space so imgui.image and flux_image accept either.
+    RenderTargetPool m_RenderTargets;
+    TexturePool m_Textures;
+    PixelReadback m_Readbacks;
+    std::unordered_map<int, sol::protected_function> m_ReadbackCallbacks;
     int m_NextImageId = 1;
     std::vector<uint8_t> m_ImageScratchBuffer;
     static constexpr size_t kMaxConsoleLines = 200;
@@ -0,0 +1,88 @@
+#include "LuaSyntaxChecker.hpp"
+
+#include <lua.hpp>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // Same chunk name as LuaScriptHost::CompileScript, so messages read "script:LINE: ...".
+    constexpr const char* kChunkName = "=script";
+    constexpr const char* kChunkPrefix = "script:";
+}
+
+LuaSyntaxChecker::LuaSyntaxChecker(Clock::duration delay)
+    : m_Delay(delay)
+{
+}
+
+LuaSyntaxChecker::~LuaSyntaxChecker()
+{
+    if (m_Job.valid())
+        m_Job.wait();
+}
+
+void LuaSyntaxChecker::NotifyEdited()
+{
+    m_Dirty = true;
+    m_Deadline = Clock::now() + m_Delay;
+    ++m_Edits;
+}
+
+bool LuaSyntaxChecker::Update(const std::function<std::string()>& getText, Result& result)
+{
+    bool updated = false;
+    if (m_Job.valid() && m_Job.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        Result finished = m_Job.get();
+        // Drop results for text that has been edited since the check started
+        if (m_JobEdits == m_Edits)
+        {
+            result = std::move(finished);
+            updated = true;
+        }
+    }
+
+    if (m_Dirty && !m_Job.valid() && Clock::now() >= m_Deadline)
+    {
+        m_Dirty = false;
+        m_JobEdits = m_Edits;
+        m_Job = std::async(std::launch::async, [source = getText()]() { return Check(source); });
+    }
+
+    return updated;
+}
+
+LuaSyntaxChecker::Result LuaSyntaxChecker::Check(const std::string& source)
+{
+    Result result;
+    lua_State* state = luaL_newstate();
+    if (!state)
+        return result;
+
+    if (luaL_loadbufferx(state, source.data(), source.size(), kChunkName, "t") != LUA_OK)
+    {
+        const char* message = lua_tostring(state, -1);
+        result.Ok = false;
+        result.Message = message ? message : "syntax error";
+
+        // "script:12: unexpected symbol near 'x'" -> line 12, "unexpected symbol near 'x'"
+        const size_t prefixLength = std::strlen(kChunkPrefix);
+        if (result.Message.compare(0, prefixLength, kChunkPrefix) == 0)
+        {
+            char* end = nullptr;
+            const long line = std::strtol(result.Message.c_str() + prefixLength, &end, 10);
+            if (end && *end == ':' && line > 0)
+            {
+                result.Line = static_cast<int>(line);
+                size_t start = static_cast<size_t>(end - result.Message.c_str()) + 1;
+                if (start < result.Message.size() && result.Message[start] == ' ')
+                    ++start;
+                result.Message.erase(0, start);
+            }
+        }
+    }
+
+    lua_close(state);
+    return result;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+
+// Parses Lua source in a throwaway lua_State on a worker thread, a short
+// while after the last edit, so syntax errors show up without rebuilding
+// the script VM.
+class LuaSyntaxChecker
+{
+public:
+    struct Result
+    {
+        bool Ok = true;
+        int Line = 0; // 1-based; 0 when the message carries no line
+        std::string Message;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    explicit LuaSyntaxChecker(Clock::duration delay = std::chrono::milliseconds(300));
+    ~LuaSyntaxChecker();
+    LuaSyntaxChecker(const LuaSyntaxChecker&) = delete;
+    LuaSyntaxChecker& operator=(const LuaSyntaxChecker&) = delete;
+
+    // Restarts the delay; the text is checked once no edit arrives for that long.
+    void NotifyEdited();
+    // Call once per frame. Starts a check with getText() when one is due and
+    // returns true when a finished check matches the current text.
+    bool Update(const std::function<std::string()>& getText, Result& result);
+
+    static Result Check(const std::string& source);
+
+private:
+    Clock::duration m_Delay;
+    Clock::time_point m_Deadline;
+    bool m_Dirty = false;
+    uint64_t m_Edits = 0;
+    uint64_t m_JobEdits = 0;
+    std::future<Result> m_Job;
+};
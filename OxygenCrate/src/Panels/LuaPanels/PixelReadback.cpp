@@ -0,0 +1,220 @@
+#include "PixelReadback.hpp"
+#include "GLDeletionQueue.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+size_t RequestBytes(int width, int height)
+{
+    return static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+}
+
+} // namespace
+
+PixelReadback::~PixelReadback()
+{
+    Clear();
+    for (const auto& entry : m_FreePackBuffers)
+        glDeleteBuffers(1, &entry.first);
+    m_FreePackBuffers.clear();
+}
+
+int PixelReadback::Request(GLuint framebuffer, int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return -1;
+
+    ReadbackEntry request;
+    request.Width = width;
+    request.Height = height;
+    const size_t bytes = RequestBytes(width, height);
+    request.PackBuffer = AcquirePackBuffer(bytes);
+
+    GLint previousRead = 0;
+    GLint previousAlignment = 4;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, request.PackBuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousRead));
+
+    request.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Make sure the fence reaches the GPU; otherwise a later non-blocking
+    // poll could wait forever on an unsubmitted command stream.
+    glFlush();
+
+    const int handle = m_NextHandle++;
+    m_Requests[handle] = std::move(request);
+    return handle;
+}
+
+std::vector<int> PixelReadback::Poll()
+{
+    // Readbacks completed by an earlier poll have had a frame to be read.
+    ReleaseOldCompleted();
+
+    std::vector<int> completed;
+    for (auto& entry : m_Requests)
+    {
+        if (entry.second.Fence != nullptr && Complete(entry.first, entry.second))
+            completed.push_back(entry.first);
+    }
+    return completed;
+}
+
+PixelReadback::Status PixelReadback::GetStatus(int handle)
+{
+    auto it = m_Requests.find(handle);
+    if (it == m_Requests.end())
+        return Status::Invalid;
+    if (it->second.Fence != nullptr && !Complete(handle, it->second))
+        return Status::Pending;
+    return it->second.Failed ? Status::Failed : Status::Ready;
+}
+
+const std::string* PixelReadback::GetData(int handle) const
+{
+    auto it = m_Requests.find(handle);
+    if (it == m_Requests.end() || it->second.Fence != nullptr || it->second.Failed)
+        return nullptr;
+    return &it->second.Data;
+}
+
+const std::string* PixelReadback::GetError(int handle) const
+{
+    auto it = m_Requests.find(handle);
+    if (it == m_Requests.end() || !it->second.Failed)
+        return nullptr;
+    return &it->second.Error;
+}
+
+bool PixelReadback::GetSize(int handle, int& width, int& height) const
+{
+    auto it = m_Requests.find(handle);
+    if (it == m_Requests.end())
+        return false;
+    width = it->second.Width;
+    height = it->second.Height;
+    return true;
+}
+
+void PixelReadback::Release(int handle)
+{
+    auto it = m_Requests.find(handle);
+    if (it == m_Requests.end())
+        return;
+    ReadbackEntry& request = it->second;
+    if (request.Fence != nullptr)
+    {
+        glDeleteSync(request.Fence);
+        RecyclePackBuffer(request.PackBuffer, RequestBytes(request.Width, request.Height));
+    }
+    else
+    {
+        m_Completed.erase(std::remove(m_Completed.begin(), m_Completed.end(), handle), m_Completed.end());
+    }
+    m_Requests.erase(it);
+}
+
+void PixelReadback::Clear()
+{
+    std::vector<int> handles;
+    handles.reserve(m_Requests.size());
+    for (const auto& entry : m_Requests)
+        handles.push_back(entry.first);
+    for (int handle : handles)
+        Release(handle);
+    m_Completed.clear();
+}
+
+size_t PixelReadback::GetPendingCount() const
+{
+    return static_cast<size_t>(std::count_if(m_Requests.begin(), m_Requests.end(), [](const auto& entry)
+    {
+        return entry.second.Fence != nullptr;
+    }));
+}
+
+bool PixelReadback::Complete(int handle, ReadbackEntry& request)
+{
+    const GLenum result = glClientWaitSync(request.Fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(request.Fence);
+    request.Fence = nullptr;
+
+    const size_t bytes = RequestBytes(request.Width, request.Height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, request.PackBuffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT);
+    if (mapped)
+    {
+        request.Data.assign(static_cast<const char*>(mapped), bytes);
+        if (glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_FALSE)
+        {
+            // The store was lost while mapped (e.g. a display mode change); the copy may be garbage.
+            request.Failed = true;
+            request.Error = "pixel pack buffer contents were lost while mapped";
+            request.Data.clear();
+        }
+    }
+    else
+    {
+        char message[64];
+        std::snprintf(message, sizeof(message), "glMapBufferRange failed (GL error 0x%04X)", glGetError());
+        request.Failed = true;
+        request.Error = message;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    RecyclePackBuffer(request.PackBuffer, bytes);
+    request.PackBuffer = 0;
+    m_Completed.push_back(handle);
+    return true;
+}
+
+GLuint PixelReadback::AcquirePackBuffer(size_t bytes)
+{
+    auto match = std::find_if(m_FreePackBuffers.begin(), m_FreePackBuffers.end(), [bytes](const auto& entry)
+    {
+        return entry.second == bytes;
+    });
+    if (match != m_FreePackBuffers.end())
+    {
+        const GLuint buffer = match->first;
+        m_FreePackBuffers.erase(match);
+        return buffer;
+    }
+
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return buffer;
+}
+
+void PixelReadback::ReleaseOldCompleted()
+{
+    while (m_Completed.size() > kMaxCompletedReadbacks)
+        Release(m_Completed.front());
+}
+
+void PixelReadback::RecyclePackBuffer(GLuint buffer, size_t bytes)
+{
+    if (buffer == 0)
+        return;
+    m_FreePackBuffers.emplace_back(buffer, bytes);
+    if (m_FreePackBuffers.size() > kMaxFreePackBuffers)
+    {
+        GLDeletionQueue::Enqueue(GLDeletionQueue::ObjectType::Buffer, m_FreePackBuffers.front().first);
+        m_FreePackBuffers.erase(m_FreePackBuffers.begin());
+    }
+}
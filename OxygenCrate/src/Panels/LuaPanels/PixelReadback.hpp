@@ -0,0 +1,72 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Asynchronous glReadPixels through pixel pack buffers. A request copies the
+// framebuffer region into a PBO and inserts a fence; the data is mapped and
+// copied out only after the fence has signalled, so the CPU never waits on
+// the GPU. Pack buffers are recycled between requests, and only the most
+// recent completed readbacks are kept until the script releases them.
+class PixelReadback
+{
+public:
+    enum class Status
+    {
+        Invalid,
+        Pending,
+        Ready,
+        Failed
+    };
+
+    PixelReadback() = default;
+    ~PixelReadback();
+    PixelReadback(const PixelReadback&) = delete;
+    PixelReadback& operator=(const PixelReadback&) = delete;
+
+    // Reads an RGBA8 region of the framebuffer. Returns -1 when the region is
+    // empty. Rows are stored bottom-up, as GL returns them.
+    int Request(GLuint framebuffer, int x, int y, int width, int height);
+    // Checks pending fences without blocking and returns the handles that
+    // completed (ready or failed) during this call. Completed readbacks beyond
+    // kMaxCompletedReadbacks are released, oldest first, on the next call.
+    std::vector<int> Poll();
+    Status GetStatus(int handle);
+    const std::string* GetData(int handle) const;
+    // Why a readback failed; nullptr unless its status is Failed.
+    const std::string* GetError(int handle) const;
+    bool GetSize(int handle, int& width, int& height) const;
+    void Release(int handle);
+    void Clear();
+
+    size_t GetPendingCount() const;
+
+private:
+    struct ReadbackEntry
+    {
+        GLuint PackBuffer = 0;
+        GLsync Fence = nullptr;
+        int Width = 0;
+        int Height = 0;
+        bool Failed = false;
+        std::string Data;
+        std::string Error;
+    };
+
+    bool Complete(int handle, ReadbackEntry& request);
+    GLuint AcquirePackBuffer(size_t bytes);
+    void RecyclePackBuffer(GLuint buffer, size_t bytes);
+    void ReleaseOldCompleted();
+
+    std::unordered_map<int, ReadbackEntry> m_Requests;
+    std::vector<std::pair<GLuint, size_t>> m_FreePackBuffers;
+    // Completed handles in completion order.
+    std::deque<int> m_Completed;
+    int m_NextHandle = 1;
+    static constexpr size_t kMaxFreePackBuffers = 4;
+    static constexpr size_t kMaxCompletedReadbacks = 16;
+};
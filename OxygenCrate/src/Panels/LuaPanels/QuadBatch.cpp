@@ -0,0 +1,230 @@
+#include "QuadBatch.hpp"
+#include "GLBackend.hpp"
+#include "GLFrameStats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+// Above this many quads the vertex indices no longer fit in 16 bits.
+constexpr std::size_t kMaxShortIndexQuads = 65536 / 4;
+constexpr std::size_t kMinIndexCapacity = 256;
+
+uint64_t MakeKey(int layer, int shader, int texture)
+{
+    const uint64_t biasedLayer = static_cast<uint64_t>(std::clamp(layer + 32768, 0, 0xFFFF));
+    return (biasedLayer << 48)
+        | ((static_cast<uint64_t>(shader) & 0xFFFFFFu) << 24)
+        | (static_cast<uint64_t>(texture) & 0xFFFFFFu);
+}
+
+// Shader and texture part of the key; the layer does not split runs.
+uint64_t StateOf(uint64_t key)
+{
+    return key & 0xFFFFFFFFFFFFull;
+}
+
+uint16_t ToUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+} // namespace
+
+QuadBatch::~QuadBatch()
+{
+    GLBackend& backend = GLBackend::Get();
+    backend.DeleteObject(GLDeletionQueue::ObjectType::VertexArray, m_VertexArray);
+    backend.DeleteObject(GLDeletionQueue::ObjectType::Buffer, m_VertexBuffer);
+    backend.DeleteObject(GLDeletionQueue::ObjectType::Buffer, m_IndexBuffer);
+}
+
+void QuadBatch::SetViewport(float width, float height)
+{
+    m_ViewWidth = width;
+    m_ViewHeight = height;
+}
+
+void QuadBatch::SetState(int shader, int texture, int layer)
+{
+    m_Shader = shader;
+    m_Texture = texture;
+    m_Key = MakeKey(layer, shader, texture);
+}
+
+void QuadBatch::Quad(float x, float y, float width, float height, const float uv[4], uint32_t color)
+{
+    const float positions[8] = {
+        x, y,
+        x + width, y,
+        x + width, y + height,
+        x, y + height,
+    };
+    PushQuad(positions, uv, color);
+}
+
+void QuadBatch::Line(float x0, float y0, float x1, float y1, float thickness, uint32_t color)
+{
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float length = std::sqrt(dx * dx + dy * dy);
+    if (length <= 0.0f)
+        return;
+    const float nx = -dy / length * thickness * 0.5f;
+    const float ny = dx / length * thickness * 0.5f;
+    const float positions[8] = {
+        x0 + nx, y0 + ny,
+        x1 + nx, y1 + ny,
+        x1 - nx, y1 - ny,
+        x0 - nx, y0 - ny,
+    };
+    static const float kFullUV[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+    PushQuad(positions, kFullUV, color);
+}
+
+void QuadBatch::PushQuad(const float positions[8], const float uv[4], uint32_t color)
+{
+    if (!m_Quads.empty() && m_Key < m_Quads.back().Key)
+        m_InOrder = false;
+
+    QuadEntry& entry = m_Quads.emplace_back();
+    entry.Key = m_Key;
+    const uint16_t us[4] = { ToUnorm16(uv[0]), ToUnorm16(uv[2]), ToUnorm16(uv[2]), ToUnorm16(uv[0]) };
+    const uint16_t vs[4] = { ToUnorm16(uv[1]), ToUnorm16(uv[1]), ToUnorm16(uv[3]), ToUnorm16(uv[3]) };
+    const bool toClip = m_ViewWidth > 0.0f && m_ViewHeight > 0.0f;
+    for (int i = 0; i < 4; ++i)
+    {
+        Vertex& vertex = entry.Corners[i];
+        vertex.X = toClip ? positions[i * 2] / m_ViewWidth * 2.0f - 1.0f : positions[i * 2];
+        vertex.Y = toClip ? 1.0f - positions[i * 2 + 1] / m_ViewHeight * 2.0f : positions[i * 2 + 1];
+        vertex.U = us[i];
+        vertex.V = vs[i];
+        vertex.Color[0] = static_cast<uint8_t>(color >> 24);
+        vertex.Color[1] = static_cast<uint8_t>(color >> 16);
+        vertex.Color[2] = static_cast<uint8_t>(color >> 8);
+        vertex.Color[3] = static_cast<uint8_t>(color);
+    }
+}
+
+void QuadBatch::Clear()
+{
+    m_Quads.clear();
+    m_InOrder = true;
+}
+
+void QuadBatch::EnsureObjects()
+{
+    if (m_VertexArray != 0)
+        return;
+
+    GLBackend& backend = GLBackend::Get();
+    m_VertexArray = backend.CreateVertexArray();
+    m_VertexBuffer = backend.CreateBufferName();
+    m_IndexBuffer = backend.CreateBufferName();
+
+    // The element buffer binding is recorded in the VAO, so its contents can
+    // be replaced later without touching the VAO again.
+    const GLsizei stride = static_cast<GLsizei>(sizeof(Vertex));
+    backend.BindVertexArray(m_VertexArray);
+    backend.BindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+    backend.EnableVertexAttribArray(0);
+    backend.VertexAttribPointer(0, 2, GL_FLOAT, false, stride, offsetof(Vertex, X));
+    backend.EnableVertexAttribArray(1);
+    backend.VertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, true, stride, offsetof(Vertex, U));
+    backend.EnableVertexAttribArray(2);
+    backend.VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, true, stride, offsetof(Vertex, Color));
+    backend.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+    backend.BindVertexArray(0);
+    backend.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void QuadBatch::EnsureIndexCapacity(std::size_t quadCount)
+{
+    if (quadCount <= m_IndexCapacity)
+        return;
+
+    std::size_t capacity = std::max(m_IndexCapacity, kMinIndexCapacity);
+    while (capacity < quadCount)
+        capacity *= 2;
+    m_IndexType = capacity <= kMaxShortIndexQuads ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    std::vector<uint32_t> indices(capacity * 6);
+    for (std::size_t quad = 0; quad < capacity; ++quad)
+    {
+        const uint32_t base = static_cast<uint32_t>(quad * 4);
+        uint32_t* out = indices.data() + quad * 6;
+        out[0] = base;
+        out[1] = base + 1;
+        out[2] = base + 2;
+        out[3] = base + 2;
+        out[4] = base + 3;
+        out[5] = base;
+    }
+
+    std::size_t bytes = indices.size() * sizeof(uint32_t);
+    if (m_IndexType == GL_UNSIGNED_SHORT)
+    {
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        bytes = narrow.size() * sizeof(uint16_t);
+        GLBackend::Get().CopyIntoBuffer(m_IndexBuffer, bytes, narrow.data(), GL_STATIC_DRAW, true);
+    }
+    else
+    {
+        GLBackend::Get().CopyIntoBuffer(m_IndexBuffer, bytes, indices.data(), GL_STATIC_DRAW, true);
+    }
+    m_IndexCapacity = capacity;
+
+    GLFrameStats::Counters& stats = GLFrameStats::Current();
+    ++stats.BufferUploads;
+    stats.BufferBytes += bytes;
+}
+
+const std::vector<QuadBatchRun>& QuadBatch::Upload()
+{
+    m_Runs.clear();
+    if (m_Quads.empty())
+        return m_Runs;
+
+    EnsureObjects();
+    EnsureIndexCapacity(m_Quads.size());
+
+    m_Order.resize(m_Quads.size());
+    for (std::size_t i = 0; i < m_Order.size(); ++i)
+        m_Order[i] = static_cast<uint32_t>(i);
+    if (!m_InOrder)
+    {
+        std::stable_sort(m_Order.begin(), m_Order.end(), [this](uint32_t a, uint32_t b) {
+            return m_Quads[a].Key < m_Quads[b].Key;
+        });
+    }
+
+    m_Upload.resize(m_Quads.size() * 4);
+    uint64_t runState = ~0ull;
+    for (std::size_t i = 0; i < m_Order.size(); ++i)
+    {
+        const QuadEntry& entry = m_Quads[m_Order[i]];
+        std::copy(std::begin(entry.Corners), std::end(entry.Corners), m_Upload.begin() + static_cast<std::ptrdiff_t>(i * 4));
+        if (StateOf(entry.Key) != runState)
+        {
+            runState = StateOf(entry.Key);
+            QuadBatchRun run;
+            run.Shader = static_cast<int>((entry.Key >> 24) & 0xFFFFFFu);
+            run.Texture = static_cast<int>(entry.Key & 0xFFFFFFu);
+            run.FirstQuad = static_cast<GLsizei>(i);
+            m_Runs.push_back(run);
+        }
+        ++m_Runs.back().QuadCount;
+    }
+
+    // Re-specifying the whole store orphans the previous frame's data instead
+    // of waiting for the GPU to finish reading it.
+    const std::size_t bytes = m_Upload.size() * sizeof(Vertex);
+    GLBackend::Get().CopyIntoBuffer(m_VertexBuffer, bytes, m_Upload.data(), GL_STREAM_DRAW, true);
+    GLFrameStats::Counters& stats = GLFrameStats::Current();
+    ++stats.BufferUploads;
+    stats.BufferBytes += bytes;
+
+    Clear();
+    return m_Runs;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+#include <cstdint>
+#include <vector>
+
+// A run of consecutive quads that share shader and texture after sorting.
+struct QuadBatchRun
+{
+    int Shader = 0;
+    int Texture = 0;
+    GLsizei FirstQuad = 0;
+    GLsizei QuadCount = 0;
+};
+
+// Collects screen-space quads and lines into a persistent vertex stream.
+// Upload sorts them by layer, shader and texture (stable, so submission order
+// is kept within a state) and returns the runs to draw. Vertex, index and
+// vertex array objects are created once and reused across frames; only the
+// vertex data is re-specified per upload.
+//
+// Vertices are 16 bytes: float2 position (attribute 0), normalized ushort2
+// texture coordinate (attribute 1) and normalized ubyte4 color (attribute 2).
+class QuadBatch
+{
+public:
+    QuadBatch() = default;
+    ~QuadBatch();
+    QuadBatch(const QuadBatch&) = delete;
+    QuadBatch& operator=(const QuadBatch&) = delete;
+
+    // With a viewport set, positions are pixels with the origin in the top-left
+    // corner; without one they are passed through as clip-space coordinates.
+    void SetViewport(float width, float height);
+    // Shader and texture are binding-level handles; the batch only sorts by them.
+    void SetState(int shader, int texture, int layer);
+
+    // uv is { u0, v0, u1, v1 }; color is 0xRRGGBBAA.
+    void Quad(float x, float y, float width, float height, const float uv[4], uint32_t color);
+    void Line(float x0, float y0, float x1, float y1, float thickness, uint32_t color);
+    void Clear();
+
+    std::size_t GetQuadCount() const { return m_Quads.size(); }
+
+    // Sorts, uploads and empties the batch. The returned runs stay valid until
+    // the next call.
+    const std::vector<QuadBatchRun>& Upload();
+    GLuint GetVertexArray() const { return m_VertexArray; }
+    GLenum GetIndexType() const { return m_IndexType; }
+
+private:
+    struct Vertex
+    {
+        float X = 0.0f;
+        float Y = 0.0f;
+        uint16_t U = 0;
+        uint16_t V = 0;
+        uint8_t Color[4] = {};
+    };
+
+    struct QuadEntry
+    {
+        uint64_t Key = 0;
+        Vertex Corners[4];
+    };
+
+    void PushQuad(const float positions[8], const float uv[4], uint32_t color);
+    void EnsureObjects();
+    void EnsureIndexCapacity(std::size_t quadCount);
+
+    float m_ViewWidth = 0.0f;
+    float m_ViewHeight = 0.0f;
+    int m_Shader = 0;
+    int m_Texture = 0;
+    uint64_t m_Key = 0;
+    bool m_InOrder = true;
+
+    std::vector<QuadEntry> m_Quads;
+    std::vector<uint32_t> m_Order;
+    std::vector<Vertex> m_Upload;
+    std::vector<QuadBatchRun> m_Runs;
+
+    GLuint m_VertexArray = 0;
+    GLuint m_VertexBuffer = 0;
+    GLuint m_IndexBuffer = 0;
+    GLenum m_IndexType = GL_UNSIGNED_SHORT;
+    std::size_t m_IndexCapacity = 0;
+};
@@ -0,0 +1,279 @@
+#include "RecordingGLBackend.hpp"
+
+RecordingGLBackend::RecordingGLBackend(bool instancing, bool multiDraw)
+    : m_Instancing(instancing)
+    , m_MultiDraw(multiDraw)
+{
+}
+
+void RecordingGLBackend::ClearCalls()
+{
+    m_Calls.clear();
+    m_CallCount = 0;
+    m_DrawCount = 0;
+    m_UploadedBytes = 0;
+}
+
+std::vector<RecordingGLBackend::LiveObject> RecordingGLBackend::GetLiveObjects() const
+{
+    std::vector<LiveObject> objects;
+    objects.reserve(m_LiveObjects.size());
+    for (const auto& [id, type] : m_LiveObjects)
+        objects.push_back(LiveObject{ type, id });
+    return objects;
+}
+
+bool RecordingGLBackend::Supports(Feature feature) const
+{
+    switch (feature)
+    {
+    case Feature::Instancing:
+        return m_Instancing;
+    case Feature::MultiDraw:
+        return m_MultiDraw;
+    case Feature::ParallelShaderCompile:
+        // Programs are "linked" at creation, so polling never has to block.
+        return true;
+    default:
+        return false;
+    }
+}
+
+void RecordingGLBackend::Record(const char* name, GLuint object, std::size_t bytes)
+{
+    ++m_CallCount;
+    m_UploadedBytes += bytes;
+    if (m_CallLimit == 0 || m_Calls.size() < m_CallLimit)
+        m_Calls.push_back(Call{ name, object, bytes });
+}
+
+void RecordingGLBackend::RecordDraw(const char* name, GLsizei draws)
+{
+    m_DrawCount += static_cast<std::size_t>(draws);
+    Record(name);
+}
+
+GLuint RecordingGLBackend::CreateObject(GLDeletionQueue::ObjectType type, const char* name, std::size_t bytes)
+{
+    const GLuint id = m_NextObject++;
+    m_LiveObjects[id] = type;
+    Record(name, id, bytes);
+    return id;
+}
+
+GLuint RecordingGLBackend::CreateBuffer(GLenum, std::size_t size, const void*, GLenum)
+{
+    return CreateObject(GLDeletionQueue::ObjectType::Buffer, "CreateBuffer", size);
+}
+
+GLuint RecordingGLBackend::CreateBufferName()
+{
+    return CreateObject(GLDeletionQueue::ObjectType::Buffer, "CreateBufferName");
+}
+
+void RecordingGLBackend::UpdateBuffer(GLuint id, GLenum, std::size_t size, const void*, GLenum)
+{
+    Record("UpdateBuffer", id, size);
+}
+
+void RecordingGLBackend::CopyIntoBuffer(GLuint id, std::size_t size, const void*, GLenum, bool reallocate)
+{
+    Record(reallocate ? "BufferData" : "BufferSubData", id, size);
+}
+
+void RecordingGLBackend::BindBuffer(GLenum, GLuint id)
+{
+    Record("BindBuffer", id);
+}
+
+GLuint RecordingGLBackend::CreateTextureName()
+{
+    return CreateObject(GLDeletionQueue::ObjectType::Texture, "CreateTextureName");
+}
+
+void RecordingGLBackend::TexImage2D(GLuint id, GLint, GLenum, GLsizei width, GLsizei height, GLenum, GLenum, const void*)
+{
+    // Sized as RGBA8; close enough for transfer accounting.
+    Record("TexImage2D", id, static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+}
+
+void RecordingGLBackend::TexSubImage2D(GLuint id, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, const void*)
+{
+    Record("TexSubImage2D", id, static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+}
+
+void RecordingGLBackend::CompressedTexImage2D(GLuint id, GLint, GLenum, GLsizei, GLsizei, GLsizei imageSize, const void*)
+{
+    Record("CompressedTexImage2D", id, static_cast<std::size_t>(imageSize));
+}
+
+void RecordingGLBackend::SetTextureSampling(GLuint id, GLenum, GLenum, GLenum, GLenum, GLint)
+{
+    Record("SetTextureSampling", id);
+}
+
+void RecordingGLBackend::GenerateMipmap(GLuint id)
+{
+    Record("GenerateMipmap", id);
+}
+
+bool RecordingGLBackend::SupportsCompressedFormat(GLenum) const
+{
+    return true;
+}
+
+void RecordingGLBackend::BindTexture(GLuint, GLenum, GLuint id)
+{
+    Record("BindTexture", id);
+}
+
+GLuint RecordingGLBackend::CreateVertexArray()
+{
+    return CreateObject(GLDeletionQueue::ObjectType::VertexArray, "CreateVertexArray");
+}
+
+void RecordingGLBackend::BindVertexArray(GLuint id)
+{
+    Record("BindVertexArray", id);
+}
+
+void RecordingGLBackend::EnableVertexAttribArray(GLuint index)
+{
+    Record("EnableVertexAttribArray", index);
+}
+
+void RecordingGLBackend::VertexAttribPointer(GLuint index, GLint, GLenum, bool, GLsizei, intptr_t)
+{
+    Record("VertexAttribPointer", index);
+}
+
+void RecordingGLBackend::VertexAttribDivisor(GLuint index, GLuint)
+{
+    Record("VertexAttribDivisor", index);
+}
+
+GLuint RecordingGLBackend::CreateProgram(const std::string&, const std::string&, std::string&)
+{
+    return CreateObject(GLDeletionQueue::ObjectType::Program, "CreateProgram");
+}
+
+ShaderProgramCache::PendingProgram RecordingGLBackend::BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc)
+{
+    ShaderProgramCache::PendingProgram pending;
+    std::string error;
+    pending.Program = CreateProgram(vertexSrc, fragmentSrc, error);
+    pending.Submitted = true;
+    pending.Linked = true;
+    return pending;
+}
+
+ShaderProgramCache::ProgramStatus RecordingGLBackend::PollProgram(ShaderProgramCache::PendingProgram& pending, bool, std::string&)
+{
+    return pending.Program != 0 ? ShaderProgramCache::ProgramStatus::Ready : ShaderProgramCache::ProgramStatus::Failed;
+}
+
+void RecordingGLBackend::CancelProgram(ShaderProgramCache::PendingProgram& pending)
+{
+    if (pending.Program != 0)
+        DeleteObject(GLDeletionQueue::ObjectType::Program, pending.Program);
+    pending = ShaderProgramCache::PendingProgram{};
+}
+
+void RecordingGLBackend::UseProgram(GLuint program)
+{
+    Record("UseProgram", program);
+}
+
+GLint RecordingGLBackend::GetUniformLocation(GLuint program, const char*)
+{
+    Record("GetUniformLocation", program);
+    return 0;
+}
+
+void RecordingGLBackend::Uniform1f(GLint, float)
+{
+    Record("Uniform1f", 0, sizeof(float));
+}
+
+bool RecordingGLBackend::SetUniformFloat(GLuint program, const char*, float)
+{
+    Record("SetUniformFloat", program, sizeof(float));
+    return program != 0;
+}
+
+void RecordingGLBackend::ClearColor(float, float, float, float)
+{
+    Record("ClearColor");
+}
+
+void RecordingGLBackend::Clear(GLbitfield)
+{
+    Record("Clear");
+}
+
+void RecordingGLBackend::Viewport(int, int, int, int)
+{
+    Record("Viewport");
+}
+
+void RecordingGLBackend::DrawArrays(GLenum, GLint, GLsizei)
+{
+    RecordDraw("DrawArrays");
+}
+
+void RecordingGLBackend::DrawElements(GLenum, GLsizei, GLenum, intptr_t)
+{
+    RecordDraw("DrawElements");
+}
+
+void RecordingGLBackend::DrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei)
+{
+    RecordDraw("DrawArraysInstanced");
+}
+
+void RecordingGLBackend::DrawElementsInstanced(GLenum, GLsizei, GLenum, intptr_t, GLsizei)
+{
+    RecordDraw("DrawElementsInstanced");
+}
+
+void RecordingGLBackend::MultiDrawArrays(GLenum, const GLint*, const GLsizei*, GLsizei drawCount)
+{
+    RecordDraw("MultiDrawArrays", drawCount);
+}
+
+void RecordingGLBackend::MultiDrawElements(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei drawCount)
+{
+    RecordDraw("MultiDrawElements", drawCount);
+}
+
+void RecordingGLBackend::DrawArraysIndirect(GLenum, const void*)
+{
+    RecordDraw("DrawArraysIndirect");
+}
+
+void RecordingGLBackend::DrawElementsIndirect(GLenum, GLenum, const void*)
+{
+    RecordDraw("DrawElementsIndirect");
+}
+
+void RecordingGLBackend::MultiDrawArraysIndirect(GLenum, const void*, GLsizei drawCount, GLsizei)
+{
+    RecordDraw("MultiDrawArraysIndirect", drawCount);
+}
+
+void RecordingGLBackend::MultiDrawElementsIndirect(GLenum, GLenum, const void*, GLsizei drawCount, GLsizei)
+{
+    RecordDraw("MultiDrawElementsIndirect", drawCount);
+}
+
+void RecordingGLBackend::DeleteObject(GLDeletionQueue::ObjectType type, GLuint id)
+{
+    if (id == 0)
+        return;
+    auto it = m_LiveObjects.find(id);
+    if (it == m_LiveObjects.end() || it->second != type)
+        ++m_InvalidDeletes;
+    else
+        m_LiveObjects.erase(it);
+    Record("DeleteObject", id);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "GLBackend.hpp"
+#include <map>
+#include <vector>
+
+// Headless backend that never touches GL. Every call is appended to a log with
+// the number of bytes it would have transferred, and objects get fake names
+// whose lifetimes are tracked, so scripts can run without a context for
+// benchmarks and leak checks.
+class RecordingGLBackend final : public GLBackend
+{
+public:
+    struct Call
+    {
+        const char* Name = "";
+        GLuint Object = 0;
+        std::size_t Bytes = 0;
+    };
+
+    struct LiveObject
+    {
+        GLDeletionQueue::ObjectType Type = GLDeletionQueue::ObjectType::Buffer;
+        GLuint Id = 0;
+    };
+
+    // Features reported as supported; everything else takes the fallback path.
+    explicit RecordingGLBackend(bool instancing = true, bool multiDraw = false);
+
+    const std::vector<Call>& GetCalls() const { return m_Calls; }
+    // Stops appending to the log (counters keep running) once it holds this
+    // many calls. Zero means unlimited.
+    void SetCallLimit(std::size_t limit) { m_CallLimit = limit; }
+    void ClearCalls();
+    std::size_t GetCallCount() const { return m_CallCount; }
+    std::size_t GetDrawCount() const { return m_DrawCount; }
+    std::size_t GetUploadedBytes() const { return m_UploadedBytes; }
+
+    // Objects created but not yet deleted.
+    std::vector<LiveObject> GetLiveObjects() const;
+    // Deletions of names that were never created or were already deleted.
+    std::size_t GetInvalidDeleteCount() const { return m_InvalidDeletes; }
+
+    const char* GetName() const override { return "recording"; }
+    bool IsHeadless() const override { return true; }
+    bool Supports(Feature feature) const override;
+
+    GLuint CreateBuffer(GLenum target, std::size_t size, const void* data, GLenum usage) override;
+    GLuint CreateBufferName() override;
+    void UpdateBuffer(GLuint id, GLenum target, std::size_t size, const void* data, GLenum usage) override;
+    void CopyIntoBuffer(GLuint id, std::size_t size, const void* data, GLenum usage, bool reallocate) override;
+    void BindBuffer(GLenum target, GLuint id) override;
+
+    GLuint CreateTextureName() override;
+    void TexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) override;
+    void TexSubImage2D(GLuint id, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data) override;
+    void CompressedTexImage2D(GLuint id, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei imageSize, const void* data) override;
+    void SetTextureSampling(GLuint id, GLenum minFilter, GLenum magFilter, GLenum wrapS, GLenum wrapT, GLint maxLevel) override;
+    void GenerateMipmap(GLuint id) override;
+    bool SupportsCompressedFormat(GLenum internalFormat) const override;
+    void BindTexture(GLuint unit, GLenum target, GLuint id) override;
+
+    GLuint CreateVertexArray() override;
+    void BindVertexArray(GLuint id) override;
+    void EnableVertexAttribArray(GLuint index) override;
+    void VertexAttribPointer(GLuint index, GLint size, GLenum type, bool normalized, GLsizei stride, intptr_t offset) override;
+    void VertexAttribDivisor(GLuint index, GLuint divisor) override;
+
+    GLuint CreateProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error) override;
+    ShaderProgramCache::PendingProgram BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc) override;
+    ShaderProgramCache::ProgramStatus PollProgram(ShaderProgramCache::PendingProgram& pending, bool allowBlocking, std::string& error) override;
+    void CancelProgram(ShaderProgramCache::PendingProgram& pending) override;
+    void UseProgram(GLuint program) override;
+    GLint GetUniformLocation(GLuint program, const char* name) override;
+    void Uniform1f(GLint location, float value) override;
+    bool SetUniformFloat(GLuint program, const char* name, float value) override;
+
+    void ClearColor(float r, float g, float b, float a) override;
+    void Clear(GLbitfield mask) override;
+    void Viewport(int x, int y, int width, int height) override;
+
+    void DrawArrays(GLenum mode, GLint first, GLsizei count) override;
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, intptr_t offset) override;
+    void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) override;
+    void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, intptr_t offset, GLsizei instances) override;
+    void MultiDrawArrays(GLenum mode, const GLint* firsts, const GLsizei* counts, GLsizei drawCount) override;
+    void MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum type, const void* const* indices, GLsizei drawCount) override;
+    void DrawArraysIndirect(GLenum mode, const void* indirect) override;
+    void DrawElementsIndirect(GLenum mode, GLenum type, const void* indirect) override;
+    void MultiDrawArraysIndirect(GLenum mode, const void* indirect, GLsizei drawCount, GLsizei stride) override;
+    void MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) override;
+
+    void DeleteObject(GLDeletionQueue::ObjectType type, GLuint id) override;
+
+private:
+    void Record(const char* name, GLuint object = 0, std::size_t bytes = 0);
+    // Multi-draws count every entry, matching GLFrameStats::Counters::DrawCalls.
+    void RecordDraw(const char* name, GLsizei draws = 1);
+    GLuint CreateObject(GLDeletionQueue::ObjectType type, const char* name, std::size_t bytes = 0);
+
+    bool m_Instancing = true;
+    bool m_MultiDraw = false;
+    std::vector<Call> m_Calls;
+    std::size_t m_CallLimit = 0;
+    std::size_t m_CallCount = 0;
+    std::size_t m_DrawCount = 0;
+    std::size_t m_UploadedBytes = 0;
+    std::size_t m_InvalidDeletes = 0;
+    GLuint m_NextObject = 1;
+    std::map<GLuint, GLDeletionQueue::ObjectType> m_LiveObjects;
+};
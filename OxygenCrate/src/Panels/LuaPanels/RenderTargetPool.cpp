@@ -0,0 +1,322 @@
+#include "RenderTargetPool.hpp"
+#include "GLCapabilities.hpp"
+#include "GLDeletionQueue.hpp"
+#include <algorithm>
+
+namespace {
+
+struct PixelTransfer
+{
+    GLenum Format;
+    GLenum Type;
+};
+
+// glTexImage2D needs a matching client format/type for each internal format.
+PixelTransfer GetPixelTransfer(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_R8:
+        return { GL_RED, GL_UNSIGNED_BYTE };
+    case GL_RG8:
+        return { GL_RG, GL_UNSIGNED_BYTE };
+    case GL_RGBA16F:
+        return { GL_RGBA, GL_HALF_FLOAT };
+    case GL_RGB10_A2:
+        return { GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV };
+    default:
+        return { GL_RGBA, GL_UNSIGNED_BYTE };
+    }
+}
+
+bool IsSupportedColorFormat(GLenum format)
+{
+    return format == GL_RGBA8 || format == GL_R8 || format == GL_RG8 || format == GL_RGBA16F || format == GL_RGB10_A2;
+}
+
+int ClampSamples(int samples)
+{
+    if (samples <= 1)
+        return 1;
+    GLint maxSamples = 1;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    return std::max(1, std::min(samples, static_cast<int>(maxSamples)));
+}
+
+} // namespace
+
+RenderTargetPool::~RenderTargetPool()
+{
+    ReleaseAll();
+    for (const Attachment& attachment : m_FreeAttachments)
+        DestroyAttachment(attachment);
+    m_FreeAttachments.clear();
+}
+
+bool RenderTargetPool::Create(int id, const RenderTargetDesc& desc)
+{
+    if (desc.Width == 0 || desc.Height == 0 || !IsSupportedColorFormat(desc.ColorFormat) || m_Targets.count(id) != 0)
+        return false;
+
+    RenderTarget target;
+    target.Desc = desc;
+    target.Desc.Samples = ClampSamples(desc.Samples);
+    glGenFramebuffers(1, &target.Framebuffer);
+    if (target.Desc.Samples > 1)
+        glGenFramebuffers(1, &target.ResolveFramebuffer);
+
+    if (!AttachAll(target))
+    {
+        DetachAll(target);
+        glDeleteFramebuffers(1, &target.Framebuffer);
+        if (target.ResolveFramebuffer != 0)
+            glDeleteFramebuffers(1, &target.ResolveFramebuffer);
+        return false;
+    }
+    m_Targets[id] = target;
+    return true;
+}
+
+bool RenderTargetPool::Resize(int id, uint32_t width, uint32_t height)
+{
+    auto it = m_Targets.find(id);
+    if (it == m_Targets.end() || width == 0 || height == 0)
+        return false;
+    RenderTarget& target = it->second;
+    if (target.Desc.Width == width && target.Desc.Height == height)
+        return true;
+
+    DetachAll(target);
+    target.Desc.Width = width;
+    target.Desc.Height = height;
+    target.NeedsResolve = false;
+    return AttachAll(target);
+}
+
+void RenderTargetPool::Release(int id)
+{
+    auto it = m_Targets.find(id);
+    if (it == m_Targets.end())
+        return;
+    RenderTarget& target = it->second;
+    DetachAll(target);
+    GLDeletionQueue::Enqueue(GLDeletionQueue::ObjectType::Framebuffer, target.Framebuffer);
+    GLDeletionQueue::Enqueue(GLDeletionQueue::ObjectType::Framebuffer, target.ResolveFramebuffer);
+    m_Targets.erase(it);
+}
+
+void RenderTargetPool::ReleaseAll()
+{
+    std::vector<int> ids;
+    ids.reserve(m_Targets.size());
+    for (const auto& entry : m_Targets)
+        ids.push_back(entry.first);
+    for (int id : ids)
+        Release(id);
+}
+
+bool RenderTargetPool::Contains(int id) const
+{
+    return m_Targets.count(id) != 0;
+}
+
+const RenderTargetDesc* RenderTargetPool::GetDesc(int id) const
+{
+    auto it = m_Targets.find(id);
+    return it != m_Targets.end() ? &it->second.Desc : nullptr;
+}
+
+bool RenderTargetPool::Bind(int id)
+{
+    auto it = m_Targets.find(id);
+    if (it == m_Targets.end())
+        return false;
+    Flux::GL::BindFramebuffer(GL_FRAMEBUFFER, it->second.Framebuffer);
+    if (it->second.Desc.Samples > 1)
+        it->second.NeedsResolve = true;
+    return true;
+}
+
+void RenderTargetPool::Resolve(int id)
+{
+    auto it = m_Targets.find(id);
+    if (it == m_Targets.end() || !it->second.NeedsResolve)
+        return;
+    RenderTarget& target = it->second;
+
+    GLint previousDraw = 0;
+    GLint previousRead = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+
+    const GLint width = static_cast<GLint>(target.Desc.Width);
+    const GLint height = static_cast<GLint>(target.Desc.Height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.Framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.ResolveFramebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    // Depth/stencil contents are not needed after the resolve; let tilers skip
+    // writing them back.
+    if (target.DepthStencil.Id != 0 && GLCapabilities::IsAtLeast(4, 3, 3, 0))
+    {
+        const GLenum attachment = target.Desc.Stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, 1, &attachment);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousRead));
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previousDraw));
+    target.NeedsResolve = false;
+}
+
+GLuint RenderTargetPool::GetColorTexture(int id)
+{
+    auto it = m_Targets.find(id);
+    if (it == m_Targets.end())
+        return 0;
+    Resolve(id);
+    return it->second.Color.Id;
+}
+
+GLuint RenderTargetPool::GetResolveFramebuffer(int id) const
+{
+    auto it = m_Targets.find(id);
+    if (it == m_Targets.end())
+        return 0;
+    return it->second.ResolveFramebuffer != 0 ? it->second.ResolveFramebuffer : it->second.Framebuffer;
+}
+
+RenderTargetPool::Attachment RenderTargetPool::AcquireAttachment(AttachmentKind kind, GLenum format, uint32_t width, uint32_t height, int samples)
+{
+    auto match = std::find_if(m_FreeAttachments.begin(), m_FreeAttachments.end(), [&](const Attachment& candidate)
+    {
+        return candidate.Kind == kind && candidate.Format == format && candidate.Width == width
+            && candidate.Height == height && candidate.Samples == samples;
+    });
+    if (match != m_FreeAttachments.end())
+    {
+        Attachment attachment = *match;
+        m_FreeAttachments.erase(match);
+        return attachment;
+    }
+
+    Attachment attachment;
+    attachment.Kind = kind;
+    attachment.Format = format;
+    attachment.Width = width;
+    attachment.Height = height;
+    attachment.Samples = samples;
+    const GLsizei glWidth = static_cast<GLsizei>(width);
+    const GLsizei glHeight = static_cast<GLsizei>(height);
+
+    if (kind == AttachmentKind::Texture)
+    {
+        const PixelTransfer transfer = GetPixelTransfer(format);
+        GLint previousTexture = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glGenTextures(1, &attachment.Id);
+        glBindTexture(GL_TEXTURE_2D, attachment.Id);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), glWidth, glHeight, 0, transfer.Format, transfer.Type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture));
+    }
+    else
+    {
+        glGenRenderbuffers(1, &attachment.Id);
+        glBindRenderbuffer(GL_RENDERBUFFER, attachment.Id);
+        if (samples > 1)
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, glWidth, glHeight);
+        else
+            glRenderbufferStorage(GL_RENDERBUFFER, format, glWidth, glHeight);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+    return attachment;
+}
+
+void RenderTargetPool::RecycleAttachment(Attachment& attachment)
+{
+    if (attachment.Id == 0)
+        return;
+    m_FreeAttachments.push_back(attachment);
+    if (m_FreeAttachments.size() > kMaxFreeAttachments)
+    {
+        const Attachment& oldest = m_FreeAttachments.front();
+        const auto type = oldest.Kind == AttachmentKind::Texture ? GLDeletionQueue::ObjectType::Texture : GLDeletionQueue::ObjectType::Renderbuffer;
+        GLDeletionQueue::Enqueue(type, oldest.Id);
+        m_FreeAttachments.erase(m_FreeAttachments.begin());
+    }
+    attachment = Attachment{};
+}
+
+bool RenderTargetPool::AttachAll(RenderTarget& target)
+{
+    const RenderTargetDesc& desc = target.Desc;
+    const bool multisampled = desc.Samples > 1;
+
+    target.Color = AcquireAttachment(AttachmentKind::Texture, desc.ColorFormat, desc.Width, desc.Height, 1);
+    if (multisampled)
+        target.MultisampleColor = AcquireAttachment(AttachmentKind::Renderbuffer, desc.ColorFormat, desc.Width, desc.Height, desc.Samples);
+    if (desc.Depth || desc.Stencil)
+        target.DepthStencil = AcquireAttachment(AttachmentKind::Renderbuffer, DepthStencilFormat(desc), desc.Width, desc.Height, desc.Samples);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.Framebuffer);
+    if (multisampled)
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.MultisampleColor.Id);
+    else
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.Color.Id, 0);
+    if (target.DepthStencil.Id != 0)
+    {
+        const GLenum attachmentPoint = desc.Stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachmentPoint, GL_RENDERBUFFER, target.DepthStencil.Id);
+    }
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete && multisampled)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, target.ResolveFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.Color.Id, 0);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+    return complete;
+}
+
+void RenderTargetPool::DetachAll(RenderTarget& target)
+{
+    // Attachments are only recycled, so the framebuffers keep pointing at
+    // them until the next AttachAll rebinds every attachment point it uses.
+    // Clear the depth/stencil point explicitly in case the next set has none.
+    if (target.DepthStencil.Id != 0 && target.Framebuffer != 0)
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.Framebuffer);
+        const GLenum attachmentPoint = target.Desc.Stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachmentPoint, GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+    }
+    RecycleAttachment(target.Color);
+    RecycleAttachment(target.MultisampleColor);
+    RecycleAttachment(target.DepthStencil);
+}
+
+void RenderTargetPool::DestroyAttachment(const Attachment& attachment)
+{
+    if (attachment.Id == 0)
+        return;
+    if (attachment.Kind == AttachmentKind::Texture)
+        glDeleteTextures(1, &attachment.Id);
+    else
+        glDeleteRenderbuffers(1, &attachment.Id);
+}
+
+GLenum RenderTargetPool::DepthStencilFormat(const RenderTargetDesc& desc)
+{
+    return desc.Stencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT24;
+}
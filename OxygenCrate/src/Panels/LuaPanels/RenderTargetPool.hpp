@@ -0,0 +1,89 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct RenderTargetDesc
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    GLenum ColorFormat = GL_RGBA8;
+    bool Depth = false;
+    bool Stencil = false;
+    int Samples = 1;
+};
+
+// Off-screen targets for Lua scripts. Each target renders into an FBO and ends
+// up in a single-sample color texture that ImGui can display. Multisampled
+// targets render into renderbuffers and are resolved with a blit on demand.
+// Attachments of released or resized targets go back into a free list and are
+// reused by the next request with the same size, format and sample count.
+class RenderTargetPool
+{
+public:
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    bool Create(int id, const RenderTargetDesc& desc);
+    // Keeps the id and framebuffer objects; only the attachments are swapped.
+    bool Resize(int id, uint32_t width, uint32_t height);
+    void Release(int id);
+    // Releases every target. Their attachments stay pooled for the next script.
+    void ReleaseAll();
+
+    bool Contains(int id) const;
+    const RenderTargetDesc* GetDesc(int id) const;
+    // Binds the framebuffer to draw into and marks a multisampled target as
+    // needing a resolve.
+    bool Bind(int id);
+    // Blits the multisampled color buffer into the texture if it changed.
+    void Resolve(int id);
+    // Color texture for sampling/display; resolves first when needed.
+    GLuint GetColorTexture(int id);
+    GLuint GetResolveFramebuffer(int id) const;
+
+    size_t GetFreeAttachmentCount() const { return m_FreeAttachments.size(); }
+
+private:
+    enum class AttachmentKind : uint8_t
+    {
+        Texture,
+        Renderbuffer
+    };
+
+    struct Attachment
+    {
+        GLuint Id = 0;
+        AttachmentKind Kind = AttachmentKind::Texture;
+        GLenum Format = 0;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        int Samples = 1;
+    };
+
+    struct RenderTarget
+    {
+        RenderTargetDesc Desc;
+        GLuint Framebuffer = 0;
+        GLuint ResolveFramebuffer = 0;
+        Attachment Color;
+        Attachment MultisampleColor;
+        Attachment DepthStencil;
+        bool NeedsResolve = false;
+    };
+
+    Attachment AcquireAttachment(AttachmentKind kind, GLenum format, uint32_t width, uint32_t height, int samples);
+    void RecycleAttachment(Attachment& attachment);
+    bool AttachAll(RenderTarget& target);
+    void DetachAll(RenderTarget& target);
+    static void DestroyAttachment(const Attachment& attachment);
+    static GLenum DepthStencilFormat(const RenderTargetDesc& desc);
+
+    std::unordered_map<int, RenderTarget> m_Targets;
+    std::vector<Attachment> m_FreeAttachments;
+    static constexpr size_t kMaxFreeAttachments = 16;
+};
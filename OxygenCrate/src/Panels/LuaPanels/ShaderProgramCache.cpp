@@ -0,0 +1,286 @@
+#include "ShaderProgramCache.hpp"
+#include "GLCapabilities.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+
+constexpr uint32_t kCacheMagic = 0x4253434F; // "OCSB"
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t Magic = kCacheMagic;
+    uint32_t Version = kCacheVersion;
+    uint32_t Format = 0;
+    uint32_t Length = 0;
+};
+
+std::filesystem::path s_Directory;
+
+uint64_t HashBytes(uint64_t hash, const std::string& bytes) {
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // Separator so ("ab", "c") and ("a", "bc") hash differently.
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+bool SupportsProgramBinaries() {
+    if (s_Directory.empty())
+        return false;
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+std::filesystem::path GetEntryPath(const std::string& vertexSrc, const std::string& fragmentSrc) {
+    const GLCapabilities::Info& info = GLCapabilities::Get();
+    uint64_t hash = 14695981039346656037ull;
+    hash = HashBytes(hash, vertexSrc);
+    hash = HashBytes(hash, fragmentSrc);
+    hash = HashBytes(hash, info.Vendor);
+    hash = HashBytes(hash, info.Renderer);
+    hash = HashBytes(hash, info.Version);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return s_Directory / name;
+}
+
+GLuint LoadBinary(const std::filesystem::path& path) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+        return 0;
+
+    CacheHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return 0;
+    if (header.Magic != kCacheMagic || header.Version != kCacheVersion || header.Length == 0)
+        return 0;
+
+    std::vector<char> binary(header.Length);
+    if (!stream.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+        return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void StoreBinary(const std::filesystem::path& path, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    CacheHeader header;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &header.Format, binary.data());
+    if (written <= 0)
+        return;
+    header.Length = static_cast<uint32_t>(written);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::ofstream stream(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!stream.is_open())
+        return;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(binary.data(), written);
+}
+
+std::string ReadShaderLog(GLuint shader) {
+    GLint logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::string log(static_cast<size_t>(logLength > 0 ? logLength : 0), '\0');
+    if (logLength > 0)
+        glGetShaderInfoLog(shader, logLength, nullptr, log.data());
+    return std::string(log.c_str());
+}
+
+std::string ReadProgramLog(GLuint program) {
+    GLint logLength = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+    std::string log(static_cast<size_t>(logLength > 0 ? logLength : 0), '\0');
+    if (logLength > 0)
+        glGetProgramInfoLog(program, logLength, nullptr, log.data());
+    return std::string(log.c_str());
+}
+
+GLuint SubmitStage(GLenum stage, const std::string& source) {
+    GLuint shader = glCreateShader(stage);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+// Issues compile and link without querying any status, so drivers with
+// parallel compilation can work in the background.
+void SubmitProgram(ShaderProgramCache::PendingProgram& pending) {
+    pending.Vertex = SubmitStage(GL_VERTEX_SHADER, pending.VertexSource);
+    pending.Fragment = SubmitStage(GL_FRAGMENT_SHADER, pending.FragmentSource);
+    pending.Program = glCreateProgram();
+    glAttachShader(pending.Program, pending.Vertex);
+    glAttachShader(pending.Program, pending.Fragment);
+    if (SupportsProgramBinaries())
+        glProgramParameteri(pending.Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(pending.Program);
+    pending.Submitted = true;
+}
+
+void ReleaseStages(ShaderProgramCache::PendingProgram& pending) {
+    if (pending.Program != 0) {
+        glDetachShader(pending.Program, pending.Vertex);
+        glDetachShader(pending.Program, pending.Fragment);
+    }
+    glDeleteShader(pending.Vertex);
+    glDeleteShader(pending.Fragment);
+    pending.Vertex = 0;
+    pending.Fragment = 0;
+}
+
+// Blocks until the driver is done; returns true once the program is linked.
+bool FinishProgram(ShaderProgramCache::PendingProgram& pending, std::string& error) {
+    GLint linked = GL_FALSE;
+    glGetProgramiv(pending.Program, GL_LINK_STATUS, &linked);
+    if (linked == GL_TRUE) {
+        ReleaseStages(pending);
+        pending.Linked = true;
+        if (!pending.Entry.empty())
+            StoreBinary(pending.Entry, pending.Program);
+        return true;
+    }
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(pending.Vertex, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        error = "Vertex shader: " + ReadShaderLog(pending.Vertex);
+    } else {
+        glGetShaderiv(pending.Fragment, GL_COMPILE_STATUS, &compiled);
+        if (compiled != GL_TRUE)
+            error = "Fragment shader: " + ReadShaderLog(pending.Fragment);
+        else
+            error = "Link: " + ReadProgramLog(pending.Program);
+    }
+    ReleaseStages(pending);
+    glDeleteProgram(pending.Program);
+    pending.Program = 0;
+    return false;
+}
+
+} // namespace
+
+namespace ShaderProgramCache {
+
+void SetDirectory(const std::filesystem::path& directory) {
+    s_Directory = directory;
+}
+
+const std::filesystem::path& GetDirectory() {
+    return s_Directory;
+}
+
+GLuint CompileProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error) {
+    PendingProgram pending;
+    pending.VertexSource = vertexSrc;
+    pending.FragmentSource = fragmentSrc;
+    SubmitProgram(pending);
+    return FinishProgram(pending, error) ? pending.Program : 0;
+}
+
+bool SupportsParallelCompile() {
+    return GLCapabilities::HasExtension("GL_KHR_parallel_shader_compile")
+        || GLCapabilities::HasExtension("GL_ARB_parallel_shader_compile");
+}
+
+PendingProgram BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc) {
+    PendingProgram pending;
+    pending.VertexSource = vertexSrc;
+    pending.FragmentSource = fragmentSrc;
+
+    if (SupportsProgramBinaries()) {
+        pending.Entry = GetEntryPath(vertexSrc, fragmentSrc);
+        std::error_code ec;
+        if (std::filesystem::exists(pending.Entry, ec)) {
+            pending.Program = LoadBinary(pending.Entry);
+            if (pending.Program != 0) {
+                pending.Linked = true;
+                return pending;
+            }
+            std::filesystem::remove(pending.Entry, ec);
+        }
+    }
+
+    if (SupportsParallelCompile())
+        SubmitProgram(pending);
+    return pending;
+}
+
+ProgramStatus PollProgram(PendingProgram& pending, bool allowBlocking, std::string& error) {
+    if (pending.Linked)
+        return ProgramStatus::Ready;
+
+    if (!pending.Submitted) {
+        if (!allowBlocking)
+            return ProgramStatus::Pending;
+        SubmitProgram(pending);
+    } else if (SupportsParallelCompile()) {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(pending.Program, GL_COMPLETION_STATUS_KHR, &completed);
+        if (completed != GL_TRUE)
+            return ProgramStatus::Pending;
+    } else if (!allowBlocking) {
+        return ProgramStatus::Pending;
+    }
+
+    return FinishProgram(pending, error) ? ProgramStatus::Ready : ProgramStatus::Failed;
+}
+
+void CancelProgram(PendingProgram& pending) {
+    if (pending.Submitted && !pending.Linked)
+        ReleaseStages(pending);
+    if (pending.Program != 0)
+        glDeleteProgram(pending.Program);
+    pending = PendingProgram{};
+}
+
+GLuint CreateProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error) {
+    if (!SupportsProgramBinaries())
+        return CompileProgram(vertexSrc, fragmentSrc, error);
+
+    const std::filesystem::path entry = GetEntryPath(vertexSrc, fragmentSrc);
+    std::error_code ec;
+    if (std::filesystem::exists(entry, ec)) {
+        if (GLuint program = LoadBinary(entry))
+            return program;
+        // The driver rejected the binary (e.g. after an update); rebuild it.
+        std::filesystem::remove(entry, ec);
+    }
+
+    GLuint program = CompileProgram(vertexSrc, fragmentSrc, error);
+    if (program == 0)
+        return 0;
+    StoreBinary(entry, program);
+    return program;
+}
+
+} // namespace ShaderProgramCache
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+#include <filesystem>
+#include <string>
+
+// Persists linked program binaries (glGetProgramBinary) on disk so scripts do
+// not pay for GLSL compilation on every run. Entries are keyed by the shader
+// sources and the driver's vendor/renderer/version strings; a rejected binary
+// is discarded and the program is rebuilt from source.
+namespace ShaderProgramCache {
+
+void SetDirectory(const std::filesystem::path& directory);
+const std::filesystem::path& GetDirectory();
+
+// Loads the program from the binary cache, or compiles it and stores the
+// binary. On failure returns 0 and fills error, like PollProgram.
+GLuint CreateProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error);
+
+// Compiles and links from source. The binary-retrievable hint is set when the
+// context can export program binaries. On failure returns 0 and fills error.
+GLuint CompileProgram(const std::string& vertexSrc, const std::string& fragmentSrc, std::string& error);
+
+// Non-blocking creation. With KHR/ARB_parallel_shader_compile the driver
+// compiles in the background and PollProgram only checks the completion
+// status. Without it, compilation is deferred until PollProgram is called with
+// allowBlocking so the caller can spread the cost across frames.
+struct PendingProgram {
+    GLuint Program = 0;
+    GLuint Vertex = 0;
+    GLuint Fragment = 0;
+    bool Submitted = false;
+    bool Linked = false;
+    std::string VertexSource;
+    std::string FragmentSource;
+    std::filesystem::path Entry;
+};
+
+enum class ProgramStatus {
+    Pending,
+    Ready,
+    Failed
+};
+
+bool SupportsParallelCompile();
+PendingProgram BeginProgram(const std::string& vertexSrc, const std::string& fragmentSrc);
+ProgramStatus PollProgram(PendingProgram& pending, bool allowBlocking, std::string& error);
+void CancelProgram(PendingProgram& pending);
+
+} // namespace ShaderProgramCache
@@ -0,0 +1,209 @@
+#include "TexturePool.hpp"
+#include "GLBackend.hpp"
+#include "GLDeletionQueue.hpp"
+#include "GLFrameStats.hpp"
+#include "KtxFile.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Representative internal formats for each compressed family. The values are
+// spelled out because not every GL header defines all of them.
+constexpr GLenum kCompressedRGBA8ETC2 = 0x9278;
+constexpr GLenum kCompressedRGBAASTC4x4 = 0x93B0;
+constexpr GLenum kCompressedRGBAS3TCDXT5 = 0x83F3;
+constexpr GLenum kCompressedRGBABPTC = 0x8E8C;
+
+int FullMipCount(uint32_t width, uint32_t height)
+{
+    int levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        ++levels;
+    return levels;
+}
+
+// Bytes taken by the first levels of an RGBA8 mip chain.
+size_t MipChainBytes(uint32_t width, uint32_t height, int levels)
+{
+    size_t bytes = 0;
+    for (int level = 0; level < levels; ++level)
+    {
+        bytes += static_cast<size_t>(width) * height * 4;
+        width = std::max(1u, width >> 1);
+        height = std::max(1u, height >> 1);
+    }
+    return bytes;
+}
+
+} // namespace
+
+TexturePool::~TexturePool()
+{
+    ReleaseAll();
+}
+
+bool TexturePool::CreateRGBA8(int id, uint32_t width, uint32_t height, const uint8_t* pixels, const TextureSampling& sampling, std::string& error)
+{
+    if (width == 0 || height == 0)
+    {
+        error = "texture size must be positive";
+        return false;
+    }
+    if (Contains(id))
+    {
+        error = "texture id already in use";
+        return false;
+    }
+
+    GLBackend& backend = GLBackend::Get();
+    Texture texture;
+    texture.Id = backend.CreateTextureName();
+    texture.Info.Width = width;
+    texture.Info.Height = height;
+    texture.Info.InternalFormat = GL_RGBA8;
+    texture.Info.Sampling = sampling;
+    backend.TexImage2D(texture.Id, 0, GL_RGBA8, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (sampling.Mipmaps)
+    {
+        backend.GenerateMipmap(texture.Id);
+        texture.Info.Levels = FullMipCount(width, height);
+    }
+    texture.Info.Bytes = MipChainBytes(width, height, texture.Info.Levels);
+    ApplySampling(texture);
+    if (pixels)
+        CountUpload(static_cast<size_t>(width) * height * 4);
+
+    m_Textures[id] = texture;
+    return true;
+}
+
+bool TexturePool::CreateFromKtx(int id, const std::string& bytes, const TextureSampling& sampling, std::string& error)
+{
+    if (Contains(id))
+    {
+        error = "texture id already in use";
+        return false;
+    }
+
+    KtxFile::Image image;
+    if (!KtxFile::Parse(bytes, image, error))
+        return false;
+
+    GLBackend& backend = GLBackend::Get();
+    if (image.IsCompressed() && !backend.SupportsCompressedFormat(image.InternalFormat))
+    {
+        char format[16];
+        std::snprintf(format, sizeof(format), "0x%04X", static_cast<unsigned int>(image.InternalFormat));
+        error = std::string("compressed format ") + format + " is not supported by this GPU";
+        return false;
+    }
+
+    Texture texture;
+    texture.Id = backend.CreateTextureName();
+    texture.Info.Width = image.Width;
+    texture.Info.Height = image.Height;
+    texture.Info.InternalFormat = image.InternalFormat;
+    texture.Info.Compressed = image.IsCompressed();
+    texture.Info.Sampling = sampling;
+
+    size_t uploaded = 0;
+    for (size_t level = 0; level < image.Levels.size(); ++level)
+    {
+        const KtxFile::Level& data = image.Levels[level];
+        const GLint glLevel = static_cast<GLint>(level);
+        const GLsizei width = static_cast<GLsizei>(data.Width);
+        const GLsizei height = static_cast<GLsizei>(data.Height);
+        if (image.IsCompressed())
+            backend.CompressedTexImage2D(texture.Id, glLevel, image.InternalFormat, width, height, static_cast<GLsizei>(data.Size), data.Data);
+        else
+            backend.TexImage2D(texture.Id, glLevel, image.InternalFormat, width, height, image.Format, image.Type, data.Data);
+        uploaded += data.Size;
+    }
+    texture.Info.Levels = static_cast<int>(image.Levels.size());
+    texture.Info.Bytes = uploaded;
+
+    // Compressed formats cannot be mipmapped by the driver.
+    if (!image.IsCompressed() && (image.GenerateMipmaps || (sampling.Mipmaps && image.Levels.size() == 1)))
+    {
+        backend.GenerateMipmap(texture.Id);
+        texture.Info.Levels = FullMipCount(image.Width, image.Height);
+        texture.Info.Bytes = uploaded * 4 / 3;
+    }
+    ApplySampling(texture);
+    CountUpload(uploaded);
+
+    m_Textures[id] = texture;
+    return true;
+}
+
+bool TexturePool::SetSampling(int id, const TextureSampling& sampling)
+{
+    auto it = m_Textures.find(id);
+    if (it == m_Textures.end())
+        return false;
+    it->second.Info.Sampling = sampling;
+    ApplySampling(it->second);
+    return true;
+}
+
+void TexturePool::Release(int id)
+{
+    auto it = m_Textures.find(id);
+    if (it == m_Textures.end())
+        return;
+    GLBackend::Get().DeleteObject(GLDeletionQueue::ObjectType::Texture, it->second.Id);
+    m_Textures.erase(it);
+}
+
+void TexturePool::ReleaseAll()
+{
+    for (const auto& entry : m_Textures)
+        GLBackend::Get().DeleteObject(GLDeletionQueue::ObjectType::Texture, entry.second.Id);
+    m_Textures.clear();
+}
+
+const TextureInfo* TexturePool::GetInfo(int id) const
+{
+    auto it = m_Textures.find(id);
+    return it == m_Textures.end() ? nullptr : &it->second.Info;
+}
+
+GLuint TexturePool::GetTexture(int id) const
+{
+    auto it = m_Textures.find(id);
+    return it == m_Textures.end() ? 0 : it->second.Id;
+}
+
+size_t TexturePool::GetResidentBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& entry : m_Textures)
+        bytes += entry.second.Info.Bytes;
+    return bytes;
+}
+
+bool TexturePool::SupportsCompressedFamily(const std::string& family)
+{
+    const GLBackend& backend = GLBackend::Get();
+    if (family == "etc2")
+        return backend.SupportsCompressedFormat(kCompressedRGBA8ETC2);
+    if (family == "astc")
+        return backend.SupportsCompressedFormat(kCompressedRGBAASTC4x4);
+    if (family == "bc")
+        return backend.SupportsCompressedFormat(kCompressedRGBAS3TCDXT5) || backend.SupportsCompressedFormat(kCompressedRGBABPTC);
+    return false;
+}
+
+void TexturePool::ApplySampling(const Texture& texture)
+{
+    const TextureSampling& sampling = texture.Info.Sampling;
+    GLBackend::Get().SetTextureSampling(texture.Id, sampling.MinFilter, sampling.MagFilter, sampling.WrapS, sampling.WrapT, texture.Info.Levels - 1);
+}
+
+void TexturePool::CountUpload(size_t bytes)
+{
+    GLFrameStats::Counters& stats = GLFrameStats::Current();
+    ++stats.TextureUploads;
+    stats.TextureBytes += bytes;
+}
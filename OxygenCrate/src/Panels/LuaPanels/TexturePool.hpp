@@ -0,0 +1,70 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+struct TextureSampling
+{
+    GLenum MinFilter = GL_LINEAR;
+    GLenum MagFilter = GL_LINEAR;
+    GLenum WrapS = GL_CLAMP_TO_EDGE;
+    GLenum WrapT = GL_CLAMP_TO_EDGE;
+    // Builds the mip chain for RGBA8 uploads and KTX files that ask for it.
+    // Compressed files must carry their own levels.
+    bool Mipmaps = false;
+};
+
+struct TextureInfo
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    GLenum InternalFormat = GL_RGBA8;
+    int Levels = 1;
+    bool Compressed = false;
+    // GPU memory of all levels as uploaded (generated levels included).
+    size_t Bytes = 0;
+    TextureSampling Sampling;
+};
+
+// Sampled 2D textures for Lua scripts: RGBA8 pixels from Lua or KTX files with
+// precompressed (ETC2/ASTC on GLES, BC on desktop) or uncompressed payloads.
+// Ids come from the host so textures share the image id space.
+class TexturePool
+{
+public:
+    TexturePool() = default;
+    ~TexturePool();
+    TexturePool(const TexturePool&) = delete;
+    TexturePool& operator=(const TexturePool&) = delete;
+
+    // pixels holds width * height RGBA8 texels, or is null for an empty texture.
+    bool CreateRGBA8(int id, uint32_t width, uint32_t height, const uint8_t* pixels, const TextureSampling& sampling, std::string& error);
+    bool CreateFromKtx(int id, const std::string& bytes, const TextureSampling& sampling, std::string& error);
+    // Mipmap filters fall back to level 0 when the texture has no mip chain.
+    bool SetSampling(int id, const TextureSampling& sampling);
+    void Release(int id);
+    void ReleaseAll();
+
+    bool Contains(int id) const { return m_Textures.count(id) != 0; }
+    const TextureInfo* GetInfo(int id) const;
+    GLuint GetTexture(int id) const;
+    size_t GetResidentBytes() const;
+
+    // "etc2", "astc" or "bc": true when the driver accepts that compressed family.
+    static bool SupportsCompressedFamily(const std::string& family);
+
+private:
+    struct Texture
+    {
+        GLuint Id = 0;
+        TextureInfo Info;
+    };
+
+    static void ApplySampling(const Texture& texture);
+    static void CountUpload(size_t bytes);
+
+    std::unordered_map<int, Texture> m_Textures;
+};
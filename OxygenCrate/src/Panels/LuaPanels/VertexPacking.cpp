@@ -0,0 +1,189 @@
+#include "VertexPacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+GLsizei ComponentBytes(GLenum type) {
+    switch (type) {
+    case GL_FLOAT:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+        return 4;
+    case GL_HALF_FLOAT:
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+bool IsPacked1010102(GLenum type) {
+    return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+}
+
+// Converts one component to an integer type. Normalized values are clamped to
+// [0, 1] or [-1, 1] and scaled; others are rounded and clamped to the range.
+template <typename T>
+T ToInteger(float value, bool normalized, double minValue, double maxValue) {
+    double scaled = value;
+    if (normalized)
+        scaled = std::clamp(static_cast<double>(value), minValue < 0.0 ? -1.0 : 0.0, 1.0) * maxValue;
+    return static_cast<T>(std::clamp(std::round(scaled), minValue, maxValue));
+}
+
+uint32_t Pack1010102(const float* components, bool isSigned, bool normalized) {
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int bits = i == 3 ? 2 : 10;
+        const uint32_t mask = (1u << bits) - 1u;
+        uint32_t field = 0;
+        if (isSigned) {
+            const double maxValue = static_cast<double>((1 << (bits - 1)) - 1);
+            field = static_cast<uint32_t>(ToInteger<int32_t>(components[i], normalized, -maxValue - 1.0, maxValue)) & mask;
+        } else {
+            field = ToInteger<uint32_t>(components[i], normalized, 0.0, static_cast<double>(mask));
+        }
+        packed |= field << (i * 10);
+    }
+    return packed;
+}
+
+template <typename T>
+void Store(uint8_t* destination, T value) {
+    std::memcpy(destination, &value, sizeof(T));
+}
+
+void WriteComponent(uint8_t* destination, GLenum type, bool normalized, float value) {
+    switch (type) {
+    case GL_FLOAT:
+        Store(destination, value);
+        break;
+    case GL_HALF_FLOAT:
+        Store(destination, VertexPacking::FloatToHalf(value));
+        break;
+    case GL_UNSIGNED_BYTE:
+        Store(destination, ToInteger<uint8_t>(value, normalized, 0.0, 255.0));
+        break;
+    case GL_BYTE:
+        Store(destination, ToInteger<int8_t>(value, normalized, -128.0, 127.0));
+        break;
+    case GL_UNSIGNED_SHORT:
+        Store(destination, ToInteger<uint16_t>(value, normalized, 0.0, 65535.0));
+        break;
+    case GL_SHORT:
+        Store(destination, ToInteger<int16_t>(value, normalized, -32768.0, 32767.0));
+        break;
+    case GL_UNSIGNED_INT:
+        Store(destination, ToInteger<uint32_t>(value, normalized, 0.0, 4294967295.0));
+        break;
+    case GL_INT:
+        Store(destination, ToInteger<int32_t>(value, normalized, -2147483648.0, 2147483647.0));
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace
+
+namespace VertexPacking {
+
+GLsizei AttributeBytes(GLenum type, GLint size) {
+    if (IsPacked1010102(type))
+        return size == 4 ? 4 : 0;
+    if (size < 1 || size > 4)
+        return 0;
+    return ComponentBytes(type) * size;
+}
+
+uint16_t FloatToHalf(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu)
+        return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0 ? 0x200u : 0u));
+
+    const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if (halfExponent >= 0x1F)
+        return static_cast<uint16_t>(sign | 0x7C00u);
+
+    if (halfExponent <= 0) {
+        // Subnormal half (or zero): shift the full mantissa into place and
+        // round to nearest even.
+        if (halfExponent < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (half & 1u)))
+            ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent (up to infinity).
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+        ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+bool Pack(const std::vector<float>& values, const std::vector<Attribute>& attributes, GLsizei stride,
+    std::vector<uint8_t>& packed, std::string& error) {
+    if (attributes.empty() || stride <= 0) {
+        error = "vertex layout is empty";
+        return false;
+    }
+
+    std::size_t componentsPerVertex = 0;
+    for (const Attribute& attribute : attributes) {
+        const GLsizei bytes = AttributeBytes(attribute.Type, attribute.Size);
+        if (bytes == 0) {
+            error = "unsupported vertex attribute type or size";
+            return false;
+        }
+        if (attribute.Offset < 0 || attribute.Offset + bytes > stride) {
+            error = "vertex attribute does not fit in the stride";
+            return false;
+        }
+        componentsPerVertex += static_cast<std::size_t>(attribute.Size);
+    }
+    if (values.empty() || values.size() % componentsPerVertex != 0) {
+        error = "value count is not a multiple of the components per vertex";
+        return false;
+    }
+
+    const std::size_t vertexCount = values.size() / componentsPerVertex;
+    packed.assign(vertexCount * static_cast<std::size_t>(stride), 0);
+
+    const float* source = values.data();
+    for (std::size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        uint8_t* base = packed.data() + vertex * static_cast<std::size_t>(stride);
+        for (const Attribute& attribute : attributes) {
+            uint8_t* destination = base + attribute.Offset;
+            if (IsPacked1010102(attribute.Type)) {
+                Store(destination, Pack1010102(source, attribute.Type == GL_INT_2_10_10_10_REV, attribute.Normalized));
+            } else {
+                const GLsizei componentBytes = ComponentBytes(attribute.Type);
+                for (GLint component = 0; component < attribute.Size; ++component)
+                    WriteComponent(destination + component * componentBytes, attribute.Type, attribute.Normalized, source[component]);
+            }
+            source += attribute.Size;
+        }
+    }
+    return true;
+}
+
+} // namespace VertexPacking
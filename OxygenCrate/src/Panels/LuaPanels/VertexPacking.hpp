@@ -0,0 +1,32 @@
+#pragma once
+
+#include "GLWrappers.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Converts float vertex data from Lua into interleaved buffers that use
+// compact attribute types (half floats, normalized integers, 2_10_10_10).
+namespace VertexPacking {
+
+struct Attribute {
+    GLenum Type = GL_FLOAT;
+    GLint Size = 0;
+    bool Normalized = false;
+    GLsizei Offset = 0;
+};
+
+// Bytes taken by one attribute of the given type and component count, or 0
+// when the type is not supported. Packed 2_10_10_10 types are always 4 bytes.
+GLsizei AttributeBytes(GLenum type, GLint size);
+
+// Writes values (all components of vertex 0, then vertex 1, ...) into packed
+// using the attribute types, offsets and stride. Returns false and fills error
+// when the layout is invalid or the value count does not match it.
+bool Pack(const std::vector<float>& values, const std::vector<Attribute>& attributes, GLsizei stride,
+    std::vector<uint8_t>& packed, std::string& error);
+
+uint16_t FloatToHalf(float value);
+
+} // namespace VertexPacking
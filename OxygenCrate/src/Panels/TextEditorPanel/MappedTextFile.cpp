@@ -0,0 +1,211 @@
+#include "MappedTextFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Bytes scanned between publishing new line starts to readers.
+    constexpr uint64_t kIndexChunkBytes = 4u << 20;
+}
+
+MappedTextFile::~MappedTextFile()
+{
+    Close();
+}
+
+bool MappedTextFile::Open(const std::filesystem::path& path, std::string& error)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = "Failed to open " + path.string();
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        error = "Failed to query size of " + path.string();
+        return false;
+    }
+
+    m_File = file;
+    m_Size = static_cast<uint64_t>(size.QuadPart);
+    if (m_Size > 0)
+    {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            if (mapping)
+                CloseHandle(mapping);
+            Close();
+            error = "Failed to map " + path.string();
+            return false;
+        }
+        m_Mapping = mapping;
+        m_Data = static_cast<const char*>(view);
+    }
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        error = "Failed to open " + path.string();
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(descriptor, &info) != 0)
+    {
+        ::close(descriptor);
+        error = "Failed to query size of " + path.string();
+        return false;
+    }
+
+    m_Descriptor = descriptor;
+    m_Size = static_cast<uint64_t>(info.st_size);
+    if (m_Size > 0)
+    {
+        void* view = mmap(nullptr, static_cast<size_t>(m_Size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (view == MAP_FAILED)
+        {
+            Close();
+            error = "Failed to map " + path.string();
+            return false;
+        }
+        madvise(view, static_cast<size_t>(m_Size), MADV_SEQUENTIAL);
+        m_Data = static_cast<const char*>(view);
+    }
+#endif
+
+    m_Open = true;
+    m_LineStarts.assign(1, 0);
+    m_IndexedBytes = 0;
+    m_CancelIndex = false;
+    m_IndexDone = false;
+    m_IndexThread = std::thread(&MappedTextFile::BuildIndex, this);
+    return true;
+}
+
+void MappedTextFile::Close()
+{
+    if (m_IndexThread.joinable())
+    {
+        m_CancelIndex = true;
+        m_IndexThread.join();
+    }
+
+#if defined(_WIN32)
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File)
+        CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = nullptr;
+#else
+    if (m_Data)
+        munmap(const_cast<char*>(m_Data), static_cast<size_t>(m_Size));
+    if (m_Descriptor >= 0)
+        ::close(m_Descriptor);
+    m_Descriptor = -1;
+#endif
+
+    m_Open = false;
+    m_Data = nullptr;
+    m_Size = 0;
+    m_IndexedBytes = 0;
+    m_IndexDone = true;
+    std::lock_guard<std::mutex> lock(m_IndexMutex);
+    m_LineStarts.clear();
+}
+
+float MappedTextFile::GetIndexProgress() const
+{
+    if (m_Size == 0)
+        return 1.0f;
+    return static_cast<float>(static_cast<double>(m_IndexedBytes.load()) / static_cast<double>(m_Size));
+}
+
+size_t MappedTextFile::GetLineCount() const
+{
+    std::lock_guard<std::mutex> lock(m_IndexMutex);
+    return CompleteLineCount();
+}
+
+size_t MappedTextFile::CompleteLineCount() const
+{
+    if (m_LineStarts.empty() || m_Size == 0)
+        return 0;
+    // The last known start only becomes a complete line once the scan reaches the end of the file.
+    return m_IndexDone.load() ? m_LineStarts.size() : m_LineStarts.size() - 1;
+}
+
+std::string MappedTextFile::ReadLines(size_t firstLine, size_t count) const
+{
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_IndexMutex);
+        const size_t available = CompleteLineCount();
+        if (firstLine >= available || count == 0)
+            return {};
+
+        const size_t lastLine = std::min(available, firstLine + count);
+        begin = m_LineStarts[firstLine];
+        end = lastLine < m_LineStarts.size() ? m_LineStarts[lastLine] : m_Size;
+    }
+
+    // The mapping is immutable, so the copy itself needs no lock.
+    if (end > begin && m_Data[end - 1] == '\n')
+        --end;
+    return std::string(m_Data + begin, static_cast<size_t>(end - begin));
+}
+
+void MappedTextFile::BuildIndex()
+{
+    std::vector<uint64_t> starts;
+    uint64_t offset = 0;
+    while (offset < m_Size && !m_CancelIndex.load())
+    {
+        const uint64_t chunkEnd = std::min(m_Size, offset + kIndexChunkBytes);
+        const char* cursor = m_Data + offset;
+        const char* const stop = m_Data + chunkEnd;
+        while (cursor < stop)
+        {
+            const void* found = std::memchr(cursor, '\n', static_cast<size_t>(stop - cursor));
+            if (!found)
+                break;
+            cursor = static_cast<const char*>(found) + 1;
+            const uint64_t next = static_cast<uint64_t>(cursor - m_Data);
+            if (next < m_Size)
+                starts.push_back(next);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_IndexMutex);
+            m_LineStarts.insert(m_LineStarts.end(), starts.begin(), starts.end());
+        }
+        starts.clear();
+        offset = chunkEnd;
+        m_IndexedBytes = offset;
+    }
+
+    m_IndexDone = true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Read-only memory mapping of a text file whose line index is built on a
+// worker thread. Lines can be read as soon as the index has reached them,
+// so huge logs open without waiting for a full scan.
+class MappedTextFile
+{
+public:
+    MappedTextFile() = default;
+    ~MappedTextFile();
+    MappedTextFile(const MappedTextFile&) = delete;
+    MappedTextFile& operator=(const MappedTextFile&) = delete;
+
+    bool Open(const std::filesystem::path& path, std::string& error);
+    void Close();
+
+    bool IsOpen() const { return m_Open; }
+    uint64_t GetSize() const { return m_Size; }
+
+    bool IsIndexing() const { return !m_IndexDone.load(); }
+    // Fraction of the file scanned so far, 0..1.
+    float GetIndexProgress() const;
+    // Lines whose end has been found. Grows while indexing and is final
+    // (a trailing line without a newline included) once indexing finishes.
+    size_t GetLineCount() const;
+
+    // Copies up to count indexed lines starting at firstLine, joined by '\n'
+    // and without the newline that ends the last one.
+    std::string ReadLines(size_t firstLine, size_t count) const;
+
+private:
+    void BuildIndex();
+    // Caller holds m_IndexMutex.
+    size_t CompleteLineCount() const;
+
+private:
+    bool m_Open = false;
+    const char* m_Data = nullptr;
+    uint64_t m_Size = 0;
+#if defined(_WIN32)
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+#else
+    int m_Descriptor = -1;
+#endif
+
+    std::thread m_IndexThread;
+    std::atomic<uint64_t> m_IndexedBytes{0};
+    std::atomic<bool> m_IndexDone{true};
+    std::atomic<bool> m_CancelIndex{false};
+    mutable std::mutex m_IndexMutex;
+    std::vector<uint64_t> m_LineStarts;
+};
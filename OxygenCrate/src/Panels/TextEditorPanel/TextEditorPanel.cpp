@@ -1,5 +1,6 @@
 #include "TextEditorPanel.hpp"
 #include "Panels/LuaPanels/LuaScriptHost.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iterator>
@@ -52,6 +53,7 @@ void TextEditorPanel::InitializeTextEditor()
 
     m_StatusMessage = "No file loaded";
     m_FileToEdit.clear();
+    ResetSyntaxCheck();
 }
 
 std::string TextEditorPanel::GetText() const
@@ -59,9 +61,19 @@ std::string TextEditorPanel::GetText() const
     return m_TextEditor.GetText();
 }
 
+std::function<size_t(char*, size_t)> TextEditorPanel::CreateTextReader() const
+{
+    return [this, line = 0, index = 0](char* buffer, size_t size) mutable
+    {
+        return m_TextEditor.ReadText(line, index, buffer, size);
+    };
+}
+
 void TextEditorPanel::SetText(const std::string& text)
 {
+    CloseLargeFile();
     m_TextEditor.SetText(text);
+    ResetSyntaxCheck();
 }
 
 void TextEditorPanel::Render()
@@ -83,7 +95,7 @@ void TextEditorPanel::Render()
                     std::snprintf(m_OpenPathBuffer.data(), m_OpenPathBuffer.size(), "%s", suggested.c_str());
                     m_OpenPopupRequested = true;
                 }
-                if (ImGui::MenuItem("Save", "Ctrl+S", false, !m_TextEditor.IsReadOnly()))
+                if (ImGui::MenuItem("Save", "Ctrl+S", false, !m_TextEditor.IsReadOnly() && !m_LargeFile))
                     TrySaveFile();
                 ImGui::EndMenu();
             }
@@ -91,7 +103,7 @@ void TextEditorPanel::Render()
             if (ImGui::BeginMenu("Edit"))
             {
                 bool readOnly = m_TextEditor.IsReadOnly();
-                if (ImGui::MenuItem("Read-only mode", nullptr, &readOnly))
+                if (ImGui::MenuItem("Read-only mode", nullptr, &readOnly, !m_LargeFile))
                     m_TextEditor.SetReadOnly(readOnly);
 
                 ImGui::Separator();
@@ -111,6 +123,8 @@ void TextEditorPanel::Render()
                     m_TextEditor.Paste();
 
                 ImGui::Separator();
+                if (ImGui::MenuItem("Find and replace", nullptr, &m_ShowFindBar) && m_ShowFindBar)
+                    ApplyFindQuery();
                 if (ImGui::MenuItem("Select all", nullptr))
                     m_TextEditor.SetSelection(TextEditor::Coordinates(), TextEditor::Coordinates(m_TextEditor.GetTotalLines(), 0));
 
@@ -137,9 +151,26 @@ void TextEditorPanel::Render()
             m_TextEditor.CanUndo() ? "*" : " ",
             m_TextEditor.GetLanguageDefinition().mName.c_str());
 
+        if (m_LargeFile)
+            UpdateLargeFileView();
+
         if (!m_StatusMessage.empty())
             ImGui::TextUnformatted(m_StatusMessage.c_str());
 
+        if (m_LargeFile)
+            DrawLargeFileControls();
+
+        if (m_ShowFindBar)
+            DrawFindBar();
+        else if (m_TextEditor.HasFindQuery())
+            m_TextEditor.ClearFindQuery();
+
+        // Still set from the previous frame's typing, or from menu edits and
+        // replace-all earlier in this frame; Render() resets it
+        if (m_TextEditor.IsTextChanged())
+            m_SyntaxChecker.NotifyEdited();
+        UpdateSyntaxCheck();
+
         m_TextEditor.Render("TextEditor");
     }
     ImGui::End();
@@ -162,6 +193,12 @@ void TextEditorPanel::Render()
 
 void TextEditorPanel::TrySaveFile()
 {
+    if (m_LargeFile)
+    {
+        m_StatusMessage = "Large files are opened read-only";
+        return;
+    }
+
     if (m_FileToEdit.empty())
     {
         auto defaultDir = GetDefaultDirectory();
@@ -206,9 +243,11 @@ void TextEditorPanel::CreateNewFileAtPath(const std::string& path)
         std::ofstream file(m_FileToEdit, std::ios::out | std::ios::trunc);
     }
 
+    CloseLargeFile();
     m_TextEditor.SetText("");
     m_FileToEdit = filePath.string();
     m_StatusMessage = "New file: " + m_FileToEdit;
+    ResetSyntaxCheck();
 }
 
 void TextEditorPanel::OpenFileAtPath(const std::string& path)
@@ -227,10 +266,182 @@ void TextEditorPanel::OpenFileAtPath(const std::string& path)
         return;
     }
 
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(absolutePath, ec);
+    if (!ec && fileSize >= kLargeFileBytes)
+    {
+        OpenLargeFile(absolutePath);
+        return;
+    }
+
+    CloseLargeFile();
     auto text = ReadFileToString(absolutePath);
     m_TextEditor.SetText(text);
     m_FileToEdit = absolutePath.string();
     m_StatusMessage = "Opened " + m_FileToEdit;
+    ResetSyntaxCheck();
+}
+
+void TextEditorPanel::OpenLargeFile(const std::filesystem::path& path)
+{
+    auto file = std::make_unique<MappedTextFile>();
+    std::string error;
+    if (!file->Open(path, error))
+    {
+        m_StatusMessage = error;
+        return;
+    }
+
+    CloseLargeFile();
+    m_LargeFile = std::move(file);
+    m_LargeFileFirstLine = 0;
+    m_LargeFileShownLines = 0;
+    m_GoToLine = 1;
+    m_TextEditor.SetText("");
+    m_TextEditor.SetReadOnly(true);
+    m_FileToEdit = path.string();
+    m_StatusMessage.clear();
+    m_TextEditor.SetErrorMarkers({});
+    UpdateLargeFileView();
+}
+
+void TextEditorPanel::CloseLargeFile()
+{
+    if (!m_LargeFile)
+        return;
+
+    m_LargeFile.reset();
+    m_LargeFileFirstLine = 0;
+    m_LargeFileShownLines = 0;
+    m_TextEditor.SetReadOnly(false);
+}
+
+void TextEditorPanel::UpdateLargeFileView()
+{
+    // Fill the window as the background index reaches its lines
+    const size_t lineCount = m_LargeFile->GetLineCount();
+    const size_t reachable = lineCount - std::min(lineCount, m_LargeFileFirstLine);
+    if (std::min(kLargeFileWindowLines, reachable) > m_LargeFileShownLines)
+        ShowLargeFileWindow(m_LargeFileFirstLine);
+
+    char buffer[128];
+    if (m_LargeFile->IsIndexing())
+    {
+        std::snprintf(buffer, sizeof(buffer), "Indexing: %.0f%% (%zu lines)", m_LargeFile->GetIndexProgress() * 100.0f, lineCount);
+        m_StatusMessage = "Opening " + m_FileToEdit + " | " + buffer;
+    }
+    else if (m_StatusMessage.rfind("Opening ", 0) == 0 || m_StatusMessage.empty())
+    {
+        std::snprintf(buffer, sizeof(buffer), "%zu lines, read-only", lineCount);
+        m_StatusMessage = "Opened " + m_FileToEdit + " | " + buffer;
+    }
+}
+
+void TextEditorPanel::ShowLargeFileWindow(size_t firstLine)
+{
+    const size_t lineCount = m_LargeFile->GetLineCount();
+    m_LargeFileFirstLine = lineCount > 0 ? std::min(firstLine, lineCount - 1) : 0;
+    m_LargeFileShownLines = std::min(kLargeFileWindowLines, lineCount - m_LargeFileFirstLine);
+    m_TextEditor.SetText(m_LargeFile->ReadLines(m_LargeFileFirstLine, kLargeFileWindowLines));
+}
+
+void TextEditorPanel::DrawLargeFileControls()
+{
+    const size_t lineCount = m_LargeFile->GetLineCount();
+    const bool indexing = m_LargeFile->IsIndexing();
+    if (indexing)
+        ImGui::ProgressBar(m_LargeFile->GetIndexProgress(), ImVec2(-1.0f, 0.0f));
+
+    // Editor line numbers are relative to the window; this row gives the file position
+    ImGui::Text("Lines %zu-%zu of %zu%s", m_LargeFileFirstLine + 1, m_LargeFileFirstLine + m_LargeFileShownLines,
+        lineCount, indexing ? "+" : "");
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(m_LargeFileFirstLine == 0);
+    if (ImGui::SmallButton("Previous"))
+        ShowLargeFileWindow(m_LargeFileFirstLine - std::min(m_LargeFileFirstLine, kLargeFileWindowLines));
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(m_LargeFileFirstLine + m_LargeFileShownLines >= lineCount);
+    if (ImGui::SmallButton("Next"))
+        ShowLargeFileWindow(m_LargeFileFirstLine + kLargeFileWindowLines);
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::InputInt("Go to line", &m_GoToLine, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue) && lineCount > 0)
+    {
+        const size_t target = std::min(static_cast<size_t>(std::max(1, m_GoToLine)) - 1, lineCount - 1);
+        ShowLargeFileWindow(target - std::min(target, kLargeFileWindowLines / 2));
+        m_TextEditor.SetCursorPosition(TextEditor::Coordinates(static_cast<int>(target - m_LargeFileFirstLine), 0));
+    }
+}
+
+void TextEditorPanel::DrawFindBar()
+{
+    bool changed = false;
+    ImGui::SetNextItemWidth(200.0f);
+    changed |= ImGui::InputText("Find", m_FindBuffer.data(), m_FindBuffer.size());
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox("Match case", &m_FindOptions.mMatchCase);
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox("Whole word", &m_FindOptions.mWholeWord);
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox("Regex", &m_FindOptions.mRegex);
+    if (changed)
+        ApplyFindQuery();
+
+    ImGui::SameLine();
+    if (ImGui::Button("Previous##Find") && !m_TextEditor.FindNext(true) && m_TextEditor.HasFindQuery())
+        m_StatusMessage = "No matches";
+    ImGui::SameLine();
+    if (ImGui::Button("Next##Find") && !m_TextEditor.FindNext() && m_TextEditor.HasFindQuery())
+        m_StatusMessage = "No matches";
+
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::InputText("Replace", m_ReplaceBuffer.data(), m_ReplaceBuffer.size());
+    ImGui::SameLine();
+    ImGui::BeginDisabled(m_TextEditor.IsReadOnly() || !m_TextEditor.HasFindQuery());
+    if (ImGui::Button("Replace all"))
+    {
+        const int replaced = m_TextEditor.ReplaceAll(m_ReplaceBuffer.data());
+        m_StatusMessage = "Replaced " + std::to_string(replaced) + (replaced == 1 ? " match" : " matches");
+    }
+    ImGui::EndDisabled();
+}
+
+void TextEditorPanel::ApplyFindQuery()
+{
+    if (!m_TextEditor.SetFindQuery(m_FindBuffer.data(), m_FindOptions))
+        m_StatusMessage = "Invalid regular expression";
+}
+
+void TextEditorPanel::ResetSyntaxCheck()
+{
+    m_TextEditor.SetErrorMarkers({});
+    m_SyntaxChecker.NotifyEdited();
+}
+
+void TextEditorPanel::UpdateSyntaxCheck()
+{
+    // Mapped files only hold a window of lines, so a parse of it would be meaningless
+    if (m_LargeFile || !IsLuaDocument())
+        return;
+
+    LuaSyntaxChecker::Result result;
+    if (!m_SyntaxChecker.Update([this]() { return m_TextEditor.GetText(); }, result))
+        return;
+
+    TextEditor::ErrorMarkers markers;
+    if (!result.Ok)
+        markers[std::max(1, result.Line)] = result.Message;
+    m_TextEditor.SetErrorMarkers(markers);
+}
+
+bool TextEditorPanel::IsLuaDocument() const
+{
+    return m_FileToEdit.empty() || std::filesystem::path(m_FileToEdit).extension() == ".lua";
 }
 
 void TextEditorPanel::DrawOpenFilePopup()
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "../../external/ImGuiTextEditor/TextEditor.h"
+#include "MappedTextFile.hpp"
+#include "Panels/LuaPanels/LuaSyntaxChecker.hpp"
 #include <imgui.h>
 #include <array>
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <string>
 
 class TextEditorPanel
@@ -13,6 +17,9 @@ public:
 
     void Render();
     std::string GetText() const;
+    // Streams the editor text in chunks without building a copy of it. Each
+    // call fills the buffer and returns the byte count, 0 at the end.
+    std::function<size_t(char* buffer, size_t size)> CreateTextReader() const;
     void SetText(const std::string& text);
 
 private:
@@ -21,8 +28,18 @@ private:
     void BeginNewFile();
     void CreateNewFileAtPath(const std::string& path);
     void OpenFileAtPath(const std::string& path);
+    void OpenLargeFile(const std::filesystem::path& path);
+    void CloseLargeFile();
+    void UpdateLargeFileView();
+    void ShowLargeFileWindow(size_t firstLine);
+    void DrawLargeFileControls();
     void DrawOpenFilePopup();
     void DrawNewFilePopup();
+    void DrawFindBar();
+    void ApplyFindQuery();
+    void ResetSyntaxCheck();
+    void UpdateSyntaxCheck();
+    bool IsLuaDocument() const;
     std::filesystem::path GetDefaultDirectory() const;
 
 private:
@@ -34,4 +51,20 @@ private:
     bool m_OpenPopupRequested = false;
     bool m_NewPopupRequested = false;
     bool m_CloseOpenPopup = false;
+
+    bool m_ShowFindBar = false;
+    std::array<char, 256> m_FindBuffer{};
+    std::array<char, 256> m_ReplaceBuffer{};
+    TextEditor::FindOptions m_FindOptions;
+
+    LuaSyntaxChecker m_SyntaxChecker;
+
+    // Files at or above kLargeFileBytes are mapped instead of read; the editor
+    // then holds a read-only window of kLargeFileWindowLines lines.
+    static constexpr uintmax_t kLargeFileBytes = 16u << 20;
+    static constexpr size_t kLargeFileWindowLines = 2000;
+    std::unique_ptr<MappedTextFile> m_LargeFile;
+    size_t m_LargeFileFirstLine = 0;
+    size_t m_LargeFileShownLines = 0;
+    int m_GoToLine = 1;
 };
@@ -3,6 +3,8 @@
 #include <string>
 #include <regex>
 #include <cmath>
+#include <cstring>
+#include <future>
 
 #include "TextEditor.h"
 
@@ -26,6 +28,7 @@ bool equals(InputIt1 first1, InputIt1 last1,
 TextEditor::TextEditor()
 	: mLineSpacing(1.0f)
 	, mUndoIndex(0)
+	, mUndoMemoryLimit(8 << 20)
 	, mTabSize(4)
 	, mOverwrite(false)
 	, mReadOnly(false)
@@ -40,13 +43,18 @@ TextEditor::TextEditor()
 	, mColorRangeMin(0)
 	, mColorRangeMax(0)
 	, mSelectionMode(SelectionMode::Normal)
-	, mCheckComments(true)
-	, mLastClick(-1.0f)
 	, mHandleKeyboardInputs(true)
 	, mHandleMouseInputs(true)
 	, mIgnoreImGuiChild(false)
 	, mShowWhitespaces(true)
+	, mTextVersion(0)
+	, mCheckComments(true)
+	, mCommentRangeMin(0)
+	, mCommentRangeMax(std::numeric_limits<int>::max())
+	, mLineWidthsFontSize(0.0f)
+	, mLineWidthsTabSize(0)
 	, mStartTime(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+	, mLastClick(-1.0f)
 {
 	SetPalette(GetDarkPalette());
 	SetLanguageDefinition(LanguageDefinition::HLSL());
@@ -60,10 +68,13 @@ TextEditor::~TextEditor()
 void TextEditor::SetLanguageDefinition(const LanguageDefinition & aLanguageDef)
 {
 	mLanguageDefinition = aLanguageDef;
-	mRegexList.clear();
 
-	for (auto& r : mLanguageDefinition.mTokenRegexStrings)
-		mRegexList.push_back(std::make_pair(std::regex(r.first, std::regex_constants::optimize), r.second));
+	// a running job keeps the previous rules alive through its own reference
+	auto rules = std::make_shared<HighlightRules>();
+	rules->mLanguageDefinition = aLanguageDef;
+	for (auto& r : aLanguageDef.mTokenRegexStrings)
+		rules->mRegexList.push_back(std::make_pair(std::regex(r.first, std::regex_constants::optimize), r.second));
+	mHighlightRules = std::move(rules);
 
 	Colorize();
 }
@@ -157,6 +168,11 @@ static int UTF8CharLength(TextEditor::Char c)
 	return 1;
 }
 
+static bool IsUTFSequence(char c)
+{
+	return (c & 0xC0) == 0x80;
+}
+
 // "Borrowed" from ImGui source
 static inline int ImTextCharToUtf8(char* buf, int buf_size, unsigned int c)
 {
@@ -315,9 +331,121 @@ void TextEditor::AddUndo(UndoRecord& aValue)
 	//	aValue.mAfter.mCursorPosition.mLine, aValue.mAfter.mCursorPosition.mColumn
 	//	);
 
-	mUndoBuffer.resize((size_t)(mUndoIndex + 1));
-	mUndoBuffer.back() = aValue;
+	// drop the redo branch along with its text
+	if (mUndoIndex < (int)mUndoBuffer.size())
+	{
+		mUndoText.resize(mUndoBuffer[mUndoIndex].mRemovedOffset);
+		mUndoBuffer.resize((size_t)mUndoIndex);
+	}
+
+	if (CoalesceUndo(aValue))
+		return;
+
+	UndoEntry entry;
+	entry.mRemovedOffset = mUndoText.size();
+	entry.mRemovedLength = aValue.mRemoved.size();
+	entry.mRemovedStart = aValue.mRemovedStart;
+	entry.mRemovedEnd = aValue.mRemovedEnd;
+	mUndoText += aValue.mRemoved;
+
+	entry.mAddedOffset = mUndoText.size();
+	entry.mAddedLength = aValue.mAdded.size();
+	entry.mAddedStart = aValue.mAddedStart;
+	entry.mAddedEnd = aValue.mAddedEnd;
+	mUndoText += aValue.mAdded;
+
+	entry.mBefore = aValue.mBefore;
+	entry.mAfter = aValue.mAfter;
+
+	mUndoBuffer.push_back(entry);
 	++mUndoIndex;
+
+	TrimUndo();
+}
+
+// Folds a single typed or backspaced character into the previous step when it
+// continues the same run on the same line, so typing a word is undone at once.
+bool TextEditor::CoalesceUndo(const UndoRecord& aValue)
+{
+	if (mUndoBuffer.empty())
+		return false;
+
+	auto& last = mUndoBuffer.back();
+	auto isSingleChar = [](const std::string& aText)
+	{
+		// newlines end a run; tabs too, since Backspace records them with single-column ranges
+		return !aText.empty() && aText[0] != '\n' && aText[0] != '\t' && UTF8CharLength(aText[0]) == (int)aText.size();
+	};
+
+	if (aValue.mRemoved.empty() && isSingleChar(aValue.mAdded) &&
+		last.mRemovedLength == 0 && last.mAddedLength > 0 &&
+		last.mAddedEnd == aValue.mAddedStart && last.mAddedStart.mLine == aValue.mAddedStart.mLine)
+	{
+		// start a new step at the first space after a word
+		const char previous = mUndoText.back();
+		if (aValue.mAdded[0] == ' ' && previous != ' ')
+			return false;
+
+		mUndoText += aValue.mAdded;
+		last.mAddedLength += aValue.mAdded.size();
+		last.mAddedEnd = aValue.mAddedEnd;
+		last.mAfter = aValue.mAfter;
+		return true;
+	}
+
+	if (aValue.mAdded.empty() && isSingleChar(aValue.mRemoved) &&
+		last.mAddedLength == 0 && last.mRemovedLength > 0 &&
+		last.mRemovedStart == aValue.mRemovedEnd && last.mRemovedStart.mLine == aValue.mRemovedStart.mLine)
+	{
+		// backspace: the character goes in front of the text removed so far, which is the tail of mUndoText
+		mUndoText.insert(last.mRemovedOffset, aValue.mRemoved);
+		last.mRemovedLength += aValue.mRemoved.size();
+		last.mRemovedStart = aValue.mRemovedStart;
+		last.mAddedOffset = mUndoText.size();
+		last.mAfter = aValue.mAfter;
+		return true;
+	}
+
+	return false;
+}
+
+void TextEditor::TrimUndo()
+{
+	if (GetUndoMemoryUsage() <= mUndoMemoryLimit || mUndoBuffer.size() < 2)
+		return;
+
+	// evict down to three quarters of the budget so the compaction below runs rarely;
+	// redo steps past mUndoIndex depend on the ones before them and are never evicted
+	const size_t target = mUndoMemoryLimit - mUndoMemoryLimit / 4;
+	size_t usage = GetUndoMemoryUsage();
+	size_t evict = 0;
+	while (evict + 1 < mUndoBuffer.size() && (int)evict < mUndoIndex && usage > target)
+	{
+		auto& entry = mUndoBuffer[evict];
+		usage -= entry.mRemovedLength + entry.mAddedLength + sizeof(UndoEntry);
+		++evict;
+	}
+
+	const size_t base = mUndoBuffer[evict].mRemovedOffset;
+	mUndoText.erase(0, base);
+	mUndoBuffer.erase(mUndoBuffer.begin(), mUndoBuffer.begin() + evict);
+	for (auto& entry : mUndoBuffer)
+	{
+		entry.mRemovedOffset -= base;
+		entry.mAddedOffset -= base;
+	}
+	mUndoIndex -= (int)evict;
+}
+
+void TextEditor::SetUndoMemoryLimit(size_t aBytes)
+{
+	mUndoMemoryLimit = aBytes;
+	TrimUndo();
+}
+
+size_t TextEditor::GetUndoMemoryUsage() const
+{
+	return mUndoText.size() + mUndoBuffer.size() * sizeof(UndoEntry);
 }
 
 TextEditor::Coordinates TextEditor::ScreenPosToCoordinates(const ImVec2& aPosition) const
@@ -332,41 +460,25 @@ TextEditor::Coordinates TextEditor::ScreenPosToCoordinates(const ImVec2& aPositi
 	if (lineNo >= 0 && lineNo < (int)mLines.size())
 	{
 		auto& line = mLines.at(lineNo);
-
-		int columnIndex = 0;
-		float columnX = 0.0f;
-
-		while ((size_t)columnIndex < line.size())
+		auto& widths = GetLineWidths(lineNo);
+		const float x = local.x - mTextStart;
+
+		// Find the glyph under x, then step past it when x lies beyond its midpoint
+		int columnIndex = (int)(std::upper_bound(widths.begin(), widths.end(), x) - widths.begin()) - 1;
+		if (columnIndex < 0)
+			columnIndex = 0;
+		else if (columnIndex >= (int)line.size())
+			columnIndex = (int)line.size();
+		else
 		{
-			float columnWidth = 0.0f;
-
-			if (line[columnIndex].mChar == '\t')
-			{
-				float spaceSize = ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, -1.0f, " ").x;
-				float oldX = columnX;
-				float newColumnX = (1.0f + std::floor((1.0f + columnX) / (float(mTabSize) * spaceSize))) * (float(mTabSize) * spaceSize);
-				columnWidth = newColumnX - oldX;
-				if (mTextStart + columnX + columnWidth * 0.5f > local.x)
-					break;
-				columnX = newColumnX;
-				columnCoord = (columnCoord / mTabSize) * mTabSize + mTabSize;
-				columnIndex++;
-			}
-			else
-			{
-				char buf[7];
-				auto d = UTF8CharLength(line[columnIndex].mChar);
-				int i = 0;
-				while (i < 6 && d-- > 0)
-					buf[i++] = line[columnIndex++].mChar;
-				buf[i] = '\0';
-				columnWidth = ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, -1.0f, buf).x;
-				if (mTextStart + columnX + columnWidth * 0.5f > local.x)
-					break;
-				columnX += columnWidth;
-				columnCoord++;
-			}
+			while (columnIndex > 0 && IsUTFSequence(line[columnIndex].mChar))
+				--columnIndex;
+			const int next = std::min((int)line.size(), columnIndex + UTF8CharLength(line[columnIndex].mChar));
+			if (x >= (widths[columnIndex] + widths[next]) * 0.5f)
+				columnIndex = next;
 		}
+
+		columnCoord = GetCharacterColumn(lineNo, columnIndex);
 	}
 
 	return SanitizeCoordinates(Coordinates(lineNo, columnCoord));
@@ -596,7 +708,10 @@ void TextEditor::RemoveLine(int aStart, int aEnd)
 	}
 	mBreakpoints = std::move(btmp);
 
+	if (mLineStartStates.size() == mLines.size() + 1)
+		mLineStartStates.erase(mLineStartStates.begin() + aStart, mLineStartStates.begin() + aEnd);
 	mLines.erase(mLines.begin() + aStart, mLines.begin() + aEnd);
+	mLineWidths.clear();
 	assert(!mLines.empty());
 
 	mTextChanged = true;
@@ -626,7 +741,10 @@ void TextEditor::RemoveLine(int aIndex)
 	}
 	mBreakpoints = std::move(btmp);
 
+	if (mLineStartStates.size() == mLines.size() + 1)
+		mLineStartStates.erase(mLineStartStates.begin() + aIndex);
 	mLines.erase(mLines.begin() + aIndex);
+	mLineWidths.clear();
 	assert(!mLines.empty());
 
 	mTextChanged = true;
@@ -636,7 +754,10 @@ TextEditor::Line& TextEditor::InsertLine(int aIndex)
 {
 	assert(!mReadOnly);
 
+	if (mLineStartStates.size() == mLines.size() + 1)
+		mLineStartStates.insert(mLineStartStates.begin() + aIndex, mLineStartStates[aIndex]);
 	auto& result = *mLines.insert(mLines.begin() + aIndex, Line());
+	mLineWidths.clear();
 
 	ErrorMarkers etmp;
 	for (auto& i : mErrorMarkers)
@@ -681,6 +802,8 @@ ImU32 TextEditor::GetGlyphColor(const Glyph & aGlyph) const
 		return mPalette[(int)PaletteIndex::Comment];
 	if (aGlyph.mMultiLineComment)
 		return mPalette[(int)PaletteIndex::MultiLineComment];
+	if (aGlyph.mLongString)
+		return mPalette[(int)PaletteIndex::String];
 	auto const color = mPalette[(int)aGlyph.mColorIndex];
 	if (aGlyph.mPreprocessor)
 	{
@@ -899,8 +1022,8 @@ void TextEditor::Render()
 			ImVec2 textScreenPos = ImVec2(lineStartScreenPos.x + mTextStart, lineStartScreenPos.y);
 
 			auto& line = mLines[lineNo];
-			longest = std::max(mTextStart + TextDistanceToLineStart(Coordinates(lineNo, GetLineMaxColumn(lineNo))), longest);
-			auto columnNo = 0;
+			auto& widths = GetLineWidths(lineNo);
+			longest = std::max(mTextStart + widths.back(), longest);
 			Coordinates lineStartCoord(lineNo, 0);
 			Coordinates lineEndCoord(lineNo, GetLineMaxColumn(lineNo));
 
@@ -924,6 +1047,18 @@ void TextEditor::Render()
 				drawList->AddRectFilled(vstart, vend, mPalette[(int)PaletteIndex::Selection]);
 			}
 
+			// Draw find matches
+			if (!mFindQuery.empty())
+			{
+				FindInLine(lineNo, mFindMatches);
+				for (auto& match : mFindMatches)
+				{
+					ImVec2 vstart(textScreenPos.x + widths[match.first], lineStartScreenPos.y);
+					ImVec2 vend(textScreenPos.x + widths[match.second], lineStartScreenPos.y + mCharAdvance.y);
+					drawList->AddRectFilled(vstart, vend, mPalette[(int)PaletteIndex::FindMatch]);
+				}
+			}
+
 			// Draw breakpoints
 			auto start = ImVec2(lineStartScreenPos.x + scrollX, lineStartScreenPos.y);
 
@@ -1008,37 +1143,32 @@ void TextEditor::Render()
 				}
 			}
 
-			// Render colorized text
-			auto prevColor = line.empty() ? mPalette[(int)PaletteIndex::Default] : GetGlyphColor(line[0]);
-			ImVec2 bufferOffset;
+			// Render colorized text: one AddText per run of same-colored glyphs, placed from the cached widths.
+			// Spaces join the run they sit in; tabs and color changes end it.
+			for (auto& glyph : line)
+				mLineBuffer.push_back(glyph.mChar);
 
-			for (int i = 0; i < line.size();)
+			auto drawSpace = [&](int aIndex)
 			{
-				auto& glyph = line[i];
-				auto color = GetGlyphColor(glyph);
-
-				if ((color != prevColor || glyph.mChar == '\t' || glyph.mChar == ' ') && !mLineBuffer.empty())
+				if (mShowWhitespaces)
 				{
-					const ImVec2 newOffset(textScreenPos.x + bufferOffset.x, textScreenPos.y + bufferOffset.y);
-					drawList->AddText(newOffset, prevColor, mLineBuffer.c_str());
-					auto textSize = ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, -1.0f, mLineBuffer.c_str(), nullptr, nullptr);
-					bufferOffset.x += textSize.x;
-					mLineBuffer.clear();
+					const auto s = ImGui::GetFontSize();
+					const auto x = textScreenPos.x + widths[aIndex] + spaceSize * 0.5f;
+					const auto y = textScreenPos.y + s * 0.5f;
+					drawList->AddCircleFilled(ImVec2(x, y), 1.5f, 0x80808080, 4);
 				}
-				prevColor = color;
+			};
 
-				if (glyph.mChar == '\t')
+			for (int i = 0; i < (int)line.size();)
+			{
+				if (line[i].mChar == '\t')
 				{
-					auto oldX = bufferOffset.x;
-					bufferOffset.x = (1.0f + std::floor((1.0f + bufferOffset.x) / (float(mTabSize) * spaceSize))) * (float(mTabSize) * spaceSize);
-					++i;
-
 					if (mShowWhitespaces)
 					{
 						const auto s = ImGui::GetFontSize();
-						const auto x1 = textScreenPos.x + oldX + 1.0f;
-						const auto x2 = textScreenPos.x + bufferOffset.x - 1.0f;
-						const auto y = textScreenPos.y + bufferOffset.y + s * 0.5f;
+						const auto x1 = textScreenPos.x + widths[i] + 1.0f;
+						const auto x2 = textScreenPos.x + widths[i + 1] - 1.0f;
+						const auto y = textScreenPos.y + s * 0.5f;
 						const ImVec2 p1(x1, y);
 						const ImVec2 p2(x2, y);
 						const ImVec2 p3(x2 - s * 0.2f, y - s * 0.2f);
@@ -1047,34 +1177,39 @@ void TextEditor::Render()
 						drawList->AddLine(p2, p3, 0x90909090);
 						drawList->AddLine(p2, p4, 0x90909090);
 					}
+					++i;
+					continue;
 				}
-				else if (glyph.mChar == ' ')
+
+				if (line[i].mChar == ' ')
 				{
-					if (mShowWhitespaces)
-					{
-						const auto s = ImGui::GetFontSize();
-						const auto x = textScreenPos.x + bufferOffset.x + spaceSize * 0.5f;
-						const auto y = textScreenPos.y + bufferOffset.y + s * 0.5f;
-						drawList->AddCircleFilled(ImVec2(x, y), 1.5f, 0x80808080, 4);
-					}
-					bufferOffset.x += spaceSize;
-					i++;
+					drawSpace(i++);
+					continue;
 				}
-				else
+
+				const auto color = GetGlyphColor(line[i]);
+				const int runStart = i;
+				int runEnd = i;
+				while (i < (int)line.size())
 				{
-					auto l = UTF8CharLength(glyph.mChar);
-					while (l-- > 0)
-						mLineBuffer.push_back(line[i++].mChar);
+					auto c = line[i].mChar;
+					if (c == '\t')
+						break;
+					if (c == ' ')
+					{
+						drawSpace(i++);
+						continue;
+					}
+					if (GetGlyphColor(line[i]) != color)
+						break;
+					i = std::min((int)line.size(), i + UTF8CharLength(c));
+					runEnd = i;
 				}
-				++columnNo;
-			}
 
-			if (!mLineBuffer.empty())
-			{
-				const ImVec2 newOffset(textScreenPos.x + bufferOffset.x, textScreenPos.y + bufferOffset.y);
-				drawList->AddText(newOffset, prevColor, mLineBuffer.c_str());
-				mLineBuffer.clear();
+				const ImVec2 runPos(textScreenPos.x + widths[runStart], textScreenPos.y);
+				drawList->AddText(runPos, color, mLineBuffer.data() + runStart, mLineBuffer.data() + runEnd);
 			}
+			mLineBuffer.clear();
 
 			++lineNo;
 		}
@@ -1154,26 +1289,39 @@ void TextEditor::Render(const char* aTitle, const ImVec2& aSize, bool aBorder)
 
 void TextEditor::SetText(const std::string & aText)
 {
+	// size the line index and every line exactly, so large files do not carry
+	// the slack of repeated vector growth
+	const char * textBegin = aText.data();
+	const char * textEnd = textBegin + aText.size();
+
 	mLines.clear();
-	mLines.emplace_back(Line());
-	for (auto chr : aText)
+	mLines.reserve(std::count(textBegin, textEnd, '\n') + 1);
+	for (const char * lineBegin = textBegin; ; )
 	{
-		if (chr == '\r')
+		const char * lineEnd = static_cast<const char *>(memchr(lineBegin, '\n', textEnd - lineBegin));
+		if (lineEnd == nullptr)
+			lineEnd = textEnd;
+
+		mLines.emplace_back(Line());
+		auto& line = mLines.back();
+		line.reserve(lineEnd - lineBegin - std::count(lineBegin, lineEnd, '\r'));
+		for (const char * p = lineBegin; p < lineEnd; ++p)
 		{
 			// ignore the carriage return character
+			if (*p != '\r')
+				line.emplace_back(Glyph(*p, PaletteIndex::Default));
 		}
-		else if (chr == '\n')
-			mLines.emplace_back(Line());
-		else
-		{
-			mLines.back().emplace_back(Glyph(chr, PaletteIndex::Default));
-		}
+
+		if (lineEnd == textEnd)
+			break;
+		lineBegin = lineEnd + 1;
 	}
 
 	mTextChanged = true;
 	mScrollToTop = true;
 
 	mUndoBuffer.clear();
+	mUndoText.clear();
 	mUndoIndex = 0;
 
 	Colorize();
@@ -1205,6 +1353,7 @@ void TextEditor::SetTextLines(const std::vector<std::string> & aLines)
 	mScrollToTop = true;
 
 	mUndoBuffer.clear();
+	mUndoText.clear();
 	mUndoIndex = 0;
 
 	Colorize();
@@ -1458,6 +1607,7 @@ void TextEditor::SetSelection(const Coordinates & aStart, const Coordinates & aE
 void TextEditor::SetTabSize(int aValue)
 {
 	mTabSize = std::max(0, std::min(32, aValue));
+	mLineWidths.clear();
 }
 
 void TextEditor::InsertText(const std::string & aValue)
@@ -1549,11 +1699,6 @@ void TextEditor::MoveDown(int aAmount, bool aSelect)
 	}
 }
 
-static bool IsUTFSequence(char c)
-{
-	return (c & 0xC0) == 0x80;
-}
-
 void TextEditor::MoveLeft(int aAmount, bool aSelect, bool aWordMode)
 {
 	if (mLines.empty())
@@ -1980,6 +2125,232 @@ void TextEditor::Paste()
 	}
 }
 
+static char ToLowerAscii(char c)
+{
+	return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+}
+
+// bytes of multi-byte UTF-8 sequences count as word characters
+static bool IsFindWordChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || (c & 0x80) != 0;
+}
+
+bool TextEditor::SetFindQuery(const std::string & aQuery, const FindOptions & aOptions)
+{
+	mFindQuery = aQuery;
+	mFindOptions = aOptions;
+	mFindNeedle = aQuery;
+	if (!aOptions.mMatchCase)
+		std::transform(mFindNeedle.begin(), mFindNeedle.end(), mFindNeedle.begin(), ToLowerAscii);
+
+	if (aOptions.mRegex && !aQuery.empty())
+	{
+		try
+		{
+			auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+			if (!aOptions.mMatchCase)
+				flags |= std::regex_constants::icase;
+			mFindRegex = std::regex(aQuery, flags);
+		}
+		catch (const std::regex_error&)
+		{
+			ClearFindQuery();
+			return false;
+		}
+	}
+	return true;
+}
+
+void TextEditor::ClearFindQuery()
+{
+	mFindQuery.clear();
+	mFindNeedle.clear();
+	mFindRegex = std::regex();
+}
+
+void TextEditor::FindInLine(int aLine, LineMatches & aMatches, const std::string * aReplacement, std::vector<std::string> * aReplacements) const
+{
+	aMatches.clear();
+	if (aReplacements != nullptr)
+		aReplacements->clear();
+	if (mFindQuery.empty() || aLine < 0 || aLine >= (int)mLines.size())
+		return;
+
+	// glyphs interleave chars with color data, so gather the bytes of this one line
+	auto& line = mLines[aLine];
+	const bool lower = !mFindOptions.mMatchCase && !mFindOptions.mRegex;
+	mFindScratch.resize(line.size());
+	for (size_t i = 0; i < line.size(); ++i)
+		mFindScratch[i] = lower ? ToLowerAscii(line[i].mChar) : line[i].mChar;
+
+	const char* data = mFindScratch.data();
+	const int size = (int)mFindScratch.size();
+	auto isWholeWord = [&](int aStart, int aEnd)
+	{
+		return !mFindOptions.mWholeWord ||
+			((aStart == 0 || !IsFindWordChar(data[aStart - 1])) && (aEnd == size || !IsFindWordChar(data[aEnd])));
+	};
+
+	if (mFindOptions.mRegex)
+	{
+		for (std::sregex_iterator it(mFindScratch.cbegin(), mFindScratch.cend(), mFindRegex), end; it != end; ++it)
+		{
+			const int start = (int)it->position(0);
+			const int stop = start + (int)it->length(0);
+			if (stop == start || !isWholeWord(start, stop))
+				continue;
+			aMatches.emplace_back(start, stop);
+			if (aReplacements != nullptr)
+				aReplacements->push_back(it->format(*aReplacement));
+		}
+		return;
+	}
+
+	// memchr finds candidates by their first byte, memcmp checks the rest
+	const int length = (int)mFindNeedle.size();
+	const char first = mFindNeedle[0];
+	int pos = 0;
+	while (pos + length <= size)
+	{
+		auto hit = (const char*)memchr(data + pos, first, (size_t)(size - length + 1 - pos));
+		if (hit == nullptr)
+			break;
+
+		const int at = (int)(hit - data);
+		if (memcmp(hit + 1, mFindNeedle.data() + 1, (size_t)(length - 1)) == 0 && isWholeWord(at, at + length))
+		{
+			aMatches.emplace_back(at, at + length);
+			if (aReplacements != nullptr)
+				aReplacements->push_back(*aReplacement);
+			pos = at + length;
+		}
+		else
+			pos = at + 1;
+	}
+}
+
+bool TextEditor::FindNext(bool aBackwards)
+{
+	if (mFindQuery.empty() || mLines.empty())
+		return false;
+
+	// step from the edge of the current match so repeated calls walk through the matches
+	auto from = HasSelection() ? (aBackwards ? mState.mSelectionStart : mState.mSelectionEnd) : GetActualCursorCoordinates();
+	const int fromIndex = GetCharacterIndex(from);
+	const int lineCount = (int)mLines.size();
+
+	LineMatches matches;
+	for (int step = 0; step <= lineCount; ++step)
+	{
+		const int lineNo = aBackwards ? ((from.mLine - step) % lineCount + lineCount) % lineCount : (from.mLine + step) % lineCount;
+		FindInLine(lineNo, matches);
+		if (matches.empty())
+			continue;
+
+		// the start line is searched twice: the part past the cursor first, the rest after wrapping around
+		const std::pair<int, int>* found = nullptr;
+		if (aBackwards)
+		{
+			for (auto it = matches.rbegin(); it != matches.rend() && found == nullptr; ++it)
+				if (step > 0 || it->first < fromIndex)
+					found = &*it;
+		}
+		else
+		{
+			for (auto it = matches.begin(); it != matches.end() && found == nullptr; ++it)
+				if (step > 0 || it->first >= fromIndex)
+					found = &*it;
+		}
+
+		if (found != nullptr)
+		{
+			Coordinates start(lineNo, GetCharacterColumn(lineNo, found->first));
+			Coordinates end(lineNo, GetCharacterColumn(lineNo, found->second));
+			SetSelection(start, end);
+			SetCursorPosition(end);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int TextEditor::ReplaceAll(const std::string & aReplacement)
+{
+	if (mReadOnly || mFindQuery.empty())
+		return 0;
+
+	// rebuild the text from the first to the last line with a match, so the
+	// whole batch is one removed/added pair in the undo history
+	LineMatches matches;
+	std::vector<std::string> replacements;
+	std::string added;
+	size_t addedEnd = 0;
+	int firstLine = -1;
+	int lastLine = -1;
+	int count = 0;
+
+	for (int lineNo = 0; lineNo < (int)mLines.size(); ++lineNo)
+	{
+		FindInLine(lineNo, matches, &aReplacement, &replacements);
+		if (matches.empty() && firstLine < 0)
+			continue;
+
+		if (firstLine < 0)
+			firstLine = lineNo;
+		else
+			added.push_back('\n');
+
+		auto& line = mLines[lineNo];
+		int index = 0;
+		for (size_t i = 0; i < matches.size(); ++i)
+		{
+			for (; index < matches[i].first; ++index)
+				added.push_back(line[index].mChar);
+			added += replacements[i];
+			index = matches[i].second;
+		}
+		for (; index < (int)line.size(); ++index)
+			added.push_back(line[index].mChar);
+
+		if (!matches.empty())
+		{
+			lastLine = lineNo;
+			addedEnd = added.size();
+			count += (int)matches.size();
+		}
+	}
+
+	if (count == 0)
+		return 0;
+
+	added.resize(addedEnd);
+
+	UndoRecord u;
+	u.mBefore = mState;
+	u.mRemovedStart = Coordinates(firstLine, 0);
+	u.mRemovedEnd = Coordinates(lastLine, GetLineMaxColumn(lastLine));
+	u.mRemoved = GetText(u.mRemovedStart, u.mRemovedEnd);
+
+	DeleteRange(u.mRemovedStart, u.mRemovedEnd);
+	auto where = u.mRemovedStart;
+	InsertTextAt(where, added.c_str());
+
+	u.mAdded = added;
+	u.mAddedStart = u.mRemovedStart;
+	u.mAddedEnd = where;
+
+	SetSelection(where, where);
+	SetCursorPosition(where);
+	u.mAfter = mState;
+	AddUndo(u);
+
+	mTextChanged = true;
+	Colorize(firstLine - 1, where.mLine - firstLine + 2);
+	return count;
+}
+
 bool TextEditor::CanUndo() const
 {
 	return !mReadOnly && mUndoIndex > 0;
@@ -1993,13 +2364,13 @@ bool TextEditor::CanRedo() const
 void TextEditor::Undo(int aSteps)
 {
 	while (CanUndo() && aSteps-- > 0)
-		mUndoBuffer[--mUndoIndex].Undo(this);
+		ApplyUndo(mUndoBuffer[--mUndoIndex]);
 }
 
 void TextEditor::Redo(int aSteps)
 {
 	while (CanRedo() && aSteps-- > 0)
-		mUndoBuffer[mUndoIndex++].Redo(this);
+		ApplyRedo(mUndoBuffer[mUndoIndex++]);
 }
 
 const TextEditor::Palette & TextEditor::GetDarkPalette()
@@ -2026,6 +2397,7 @@ const TextEditor::Palette & TextEditor::GetDarkPalette()
 			0x40000000, // Current line fill
 			0x40808080, // Current line fill (inactive)
 			0x40a0a0a0, // Current line edge
+			0x6000a0e0, // Find match
 		} };
 	return p;
 }
@@ -2054,6 +2426,7 @@ const TextEditor::Palette & TextEditor::GetLightPalette()
 			0x40000000, // Current line fill
 			0x40808080, // Current line fill (inactive)
 			0x40000000, // Current line edge
+			0x6000c0ff, // Find match
 		} };
 	return p;
 }
@@ -2082,6 +2455,7 @@ const TextEditor::Palette & TextEditor::GetRetroBluePalette()
 			0x40000000, // Current line fill
 			0x40808080, // Current line fill (inactive)
 			0x40000000, // Current line edge
+			0x6000ffff, // Find match
 		} };
 	return p;
 }
@@ -2092,6 +2466,31 @@ std::string TextEditor::GetText() const
 	return GetText(Coordinates(), Coordinates((int)mLines.size(), 0));
 }
 
+size_t TextEditor::ReadText(int& aLine, int& aIndex, char* aBuffer, size_t aSize) const
+{
+	size_t written = 0;
+	while (written < aSize && aLine < (int)mLines.size())
+	{
+		auto& line = mLines[aLine];
+		if (aIndex < (int)line.size())
+		{
+			const size_t count = std::min(aSize - written, line.size() - (size_t)aIndex);
+			for (size_t i = 0; i < count; ++i)
+				aBuffer[written + i] = line[aIndex + i].mChar;
+			written += count;
+			aIndex += (int)count;
+		}
+		else
+		{
+			aBuffer[written++] = '\n';
+			aIndex = 0;
+			++aLine;
+		}
+	}
+
+	return written;
+}
+
 std::vector<std::string> TextEditor::GetTextLines() const
 {
 	std::vector<std::string> result;
@@ -2137,23 +2536,23 @@ void TextEditor::Colorize(int aFromLine, int aLines)
 	mColorRangeMax = std::max(mColorRangeMax, toLine);
 	mColorRangeMin = std::max(0, mColorRangeMin);
 	mColorRangeMax = std::max(mColorRangeMin, mColorRangeMax);
+	mCommentRangeMin = std::min(mCommentRangeMin, std::max(0, aFromLine));
+	mCommentRangeMax = std::max(mCommentRangeMax, toLine);
 	mCheckComments = true;
+	++mTextVersion;
+	InvalidateLineWidths(aFromLine, toLine);
 }
 
-void TextEditor::ColorizeRange(int aFromLine, int aToLine)
+void TextEditor::ColorizeLines(const HighlightRules& aRules, std::vector<Line>& aLines)
 {
-	if (mLines.empty() || aFromLine >= aToLine)
-		return;
+	const LanguageDefinition& languageDefinition = aRules.mLanguageDefinition;
 
 	std::string buffer;
 	std::cmatch results;
 	std::string id;
 
-	int endLine = std::max(0, std::min((int)mLines.size(), aToLine));
-	for (int i = aFromLine; i < endLine; ++i)
+	for (auto& line : aLines)
 	{
-		auto& line = mLines[i];
-
 		if (line.empty())
 			continue;
 
@@ -2178,9 +2577,9 @@ void TextEditor::ColorizeRange(int aFromLine, int aToLine)
 
 			bool hasTokenizeResult = false;
 
-			if (mLanguageDefinition.mTokenize != nullptr)
+			if (languageDefinition.mTokenize != nullptr)
 			{
-				if (mLanguageDefinition.mTokenize(first, last, token_begin, token_end, token_color))
+				if (languageDefinition.mTokenize(first, last, token_begin, token_end, token_color))
 					hasTokenizeResult = true;
 			}
 
@@ -2189,7 +2588,7 @@ void TextEditor::ColorizeRange(int aFromLine, int aToLine)
 				// todo : remove
 				//printf("using regex for %.*s\n", first + 10 < last ? 10 : int(last - first), first);
 
-				for (auto& p : mRegexList)
+				for (auto& p : aRules.mRegexList)
 				{
 					if (std::regex_search(first, last, results, p.first, std::regex_constants::match_continuous))
 					{
@@ -2217,21 +2616,21 @@ void TextEditor::ColorizeRange(int aFromLine, int aToLine)
 					id.assign(token_begin, token_end);
 
 					// todo : allmost all language definitions use lower case to specify keywords, so shouldn't this use ::tolower ?
-					if (!mLanguageDefinition.mCaseSensitive)
+					if (!languageDefinition.mCaseSensitive)
 						std::transform(id.begin(), id.end(), id.begin(), ::toupper);
 
 					if (!line[first - bufferBegin].mPreprocessor)
 					{
-						if (mLanguageDefinition.mKeywords.count(id) != 0)
+						if (languageDefinition.mKeywords.count(id) != 0)
 							token_color = PaletteIndex::Keyword;
-						else if (mLanguageDefinition.mIdentifiers.count(id) != 0)
+						else if (languageDefinition.mIdentifiers.count(id) != 0)
 							token_color = PaletteIndex::KnownIdentifier;
-						else if (mLanguageDefinition.mPreprocIdentifiers.count(id) != 0)
+						else if (languageDefinition.mPreprocIdentifiers.count(id) != 0)
 							token_color = PaletteIndex::PreprocIdentifier;
 					}
 					else
 					{
-						if (mLanguageDefinition.mPreprocIdentifiers.count(id) != 0)
+						if (languageDefinition.mPreprocIdentifiers.count(id) != 0)
 							token_color = PaletteIndex::PreprocIdentifier;
 					}
 				}
@@ -2245,157 +2644,264 @@ void TextEditor::ColorizeRange(int aFromLine, int aToLine)
 	}
 }
 
-void TextEditor::ColorizeInternal()
+void TextEditor::ScanComments(Line& aLine, CommentScanState& aState)
 {
-	if (mLines.empty() || !mColorizerEnabled)
+	if (mLanguageDefinition.mLongBrackets)
+	{
+		ScanLongBrackets(aLine, aState);
 		return;
+	}
 
-	if (mCheckComments)
+	if (!aState.mConcatenate)
 	{
-		auto endLine = mLines.size();
-		auto endIndex = 0;
-		auto commentStartLine = endLine;
-		auto commentStartIndex = endIndex;
-		auto withinString = false;
-		auto withinSingleLineComment = false;
-		auto withinPreproc = false;
-		auto firstChar = true;			// there is no other non-whitespace characters in the line before
-		auto concatenate = false;		// '\' on the very end of the line
-		auto currentLine = 0;
-		auto currentIndex = 0;
-		while (currentLine < endLine || currentIndex < endIndex)
-		{
-			auto& line = mLines[currentLine];
-
-			if (currentIndex == 0 && !concatenate)
-			{
-				withinSingleLineComment = false;
-				withinPreproc = false;
-				firstChar = true;
-			}
+		aState.mWithinSingleLineComment = false;
+		aState.mWithinPreproc = false;
+		aState.mFirstChar = true;
+	}
+	aState.mConcatenate = false;
 
-			concatenate = false;
+	// index where the active multi-line comment started; -1 when it began on an earlier line
+	const int noComment = std::numeric_limits<int>::max();
+	int commentStartIndex = aState.mWithinMultiLineComment ? -1 : noComment;
 
-			if (!line.empty())
-			{
-				auto& g = line[currentIndex];
-				auto c = g.mChar;
+	auto pred = [](const char& a, const Glyph& b) { return a == b.mChar; };
+	auto& startStr = mLanguageDefinition.mCommentStart;
+	auto& singleStartStr = mLanguageDefinition.mSingleLineComment;
+	auto& endStr = mLanguageDefinition.mCommentEnd;
 
-				if (c != mLanguageDefinition.mPreprocChar && !isspace(c))
-					firstChar = false;
+	for (int currentIndex = 0; currentIndex < (int)aLine.size(); )
+	{
+		auto c = aLine[currentIndex].mChar;
 
-				if (currentIndex == (int)line.size() - 1 && line[line.size() - 1].mChar == '\\')
-					concatenate = true;
+		if (c != mLanguageDefinition.mPreprocChar && !isspace(c))
+			aState.mFirstChar = false;
 
-				bool inComment = (commentStartLine < currentLine || (commentStartLine == currentLine && commentStartIndex <= currentIndex));
+		if (currentIndex == (int)aLine.size() - 1 && aLine[aLine.size() - 1].mChar == '\\')
+			aState.mConcatenate = true;
 
-				if (withinString)
-				{
-					line[currentIndex].mMultiLineComment = inComment;
+		bool inComment = commentStartIndex <= currentIndex;
 
-					if (c == '\"')
-					{
-						if (currentIndex + 1 < (int)line.size() && line[currentIndex + 1].mChar == '\"')
-						{
-							currentIndex += 1;
-							if (currentIndex < (int)line.size())
-								line[currentIndex].mMultiLineComment = inComment;
-						}
-						else
-							withinString = false;
-					}
-					else if (c == '\\')
-					{
-						currentIndex += 1;
-						if (currentIndex < (int)line.size())
-							line[currentIndex].mMultiLineComment = inComment;
-					}
+		if (aState.mWithinString)
+		{
+			aLine[currentIndex].mMultiLineComment = inComment;
+
+			if (c == '\"')
+			{
+				if (currentIndex + 1 < (int)aLine.size() && aLine[currentIndex + 1].mChar == '\"')
+				{
+					currentIndex += 1;
+					if (currentIndex < (int)aLine.size())
+						aLine[currentIndex].mMultiLineComment = inComment;
 				}
 				else
-				{
-					if (firstChar && c == mLanguageDefinition.mPreprocChar)
-						withinPreproc = true;
+					aState.mWithinString = false;
+			}
+			else if (c == '\\')
+			{
+				currentIndex += 1;
+				if (currentIndex < (int)aLine.size())
+					aLine[currentIndex].mMultiLineComment = inComment;
+			}
+		}
+		else
+		{
+			if (aState.mFirstChar && c == mLanguageDefinition.mPreprocChar)
+				aState.mWithinPreproc = true;
 
-					if (c == '\"')
-					{
-						withinString = true;
-						line[currentIndex].mMultiLineComment = inComment;
-					}
-					else
-					{
-						auto pred = [](const char& a, const Glyph& b) { return a == b.mChar; };
-						auto from = line.begin() + currentIndex;
-						auto& startStr = mLanguageDefinition.mCommentStart;
-						auto& singleStartStr = mLanguageDefinition.mSingleLineComment;
-
-						if (singleStartStr.size() > 0 &&
-							currentIndex + singleStartStr.size() <= line.size() &&
-							equals(singleStartStr.begin(), singleStartStr.end(), from, from + singleStartStr.size(), pred))
-						{
-							withinSingleLineComment = true;
-						}
-						else if (!withinSingleLineComment && currentIndex + startStr.size() <= line.size() &&
-							equals(startStr.begin(), startStr.end(), from, from + startStr.size(), pred))
-						{
-							commentStartLine = currentLine;
-							commentStartIndex = currentIndex;
-						}
+			if (c == '\"')
+			{
+				aState.mWithinString = true;
+				aLine[currentIndex].mMultiLineComment = inComment;
+			}
+			else
+			{
+				auto from = aLine.begin() + currentIndex;
 
-						inComment = inComment = (commentStartLine < currentLine || (commentStartLine == currentLine && commentStartIndex <= currentIndex));
+				if (singleStartStr.size() > 0 &&
+					currentIndex + singleStartStr.size() <= aLine.size() &&
+					equals(singleStartStr.begin(), singleStartStr.end(), from, from + singleStartStr.size(), pred))
+				{
+					aState.mWithinSingleLineComment = true;
+				}
+				else if (!aState.mWithinSingleLineComment && currentIndex + startStr.size() <= aLine.size() &&
+					equals(startStr.begin(), startStr.end(), from, from + startStr.size(), pred))
+				{
+					commentStartIndex = currentIndex;
+				}
 
-						line[currentIndex].mMultiLineComment = inComment;
-						line[currentIndex].mComment = withinSingleLineComment;
+				inComment = commentStartIndex <= currentIndex;
 
-						auto& endStr = mLanguageDefinition.mCommentEnd;
-						if (currentIndex + 1 >= (int)endStr.size() &&
-							equals(endStr.begin(), endStr.end(), from + 1 - endStr.size(), from + 1, pred))
-						{
-							commentStartIndex = endIndex;
-							commentStartLine = endLine;
-						}
-					}
-				}
-				line[currentIndex].mPreprocessor = withinPreproc;
-				currentIndex += UTF8CharLength(c);
-				if (currentIndex >= (int)line.size())
+				aLine[currentIndex].mMultiLineComment = inComment;
+				aLine[currentIndex].mComment = aState.mWithinSingleLineComment;
+
+				if (currentIndex + 1 >= (int)endStr.size() &&
+					equals(endStr.begin(), endStr.end(), from + 1 - endStr.size(), from + 1, pred))
 				{
-					currentIndex = 0;
-					++currentLine;
+					commentStartIndex = noComment;
 				}
 			}
-			else
-			{
-				currentIndex = 0;
-				++currentLine;
-			}
 		}
-		mCheckComments = false;
+		aLine[currentIndex].mPreprocessor = aState.mWithinPreproc;
+		currentIndex += UTF8CharLength(c);
 	}
 
-	if (mColorRangeMin < mColorRangeMax)
-	{
-		const int increment = (mLanguageDefinition.mTokenize == nullptr) ? 10 : 10000;
-		const int to = std::min(mColorRangeMin + increment, mColorRangeMax);
-		ColorizeRange(mColorRangeMin, to);
-		mColorRangeMin = to;
+	aState.mWithinMultiLineComment = commentStartIndex != noComment;
+}
 
-		if (mColorRangeMax == mColorRangeMin)
+void TextEditor::ColorizeInternal()
+{
+	if (mLines.empty() || !mColorizerEnabled)
+		return;
+
+	if (mCheckComments)
+	{
+		const int lineCount = (int)mLines.size();
+
+		// the cache is out of step with the text (new text, language change): rescan everything
+		if (mLineStartStates.size() != mLines.size() + 1)
 		{
-			mColorRangeMin = std::numeric_limits<int>::max();
-			mColorRangeMax = 0;
+			mLineStartStates.assign(mLines.size() + 1, CommentScanState());
+			mCommentRangeMin = 0;
+			mCommentRangeMax = lineCount;
 		}
+
+		int currentLine = std::min(mCommentRangeMin, lineCount);
+		CommentScanState state = currentLine == 0 ? CommentScanState() : mLineStartStates[currentLine];
+		for (; currentLine < lineCount; ++currentLine)
+		{
+			mLineStartStates[currentLine] = state;
+			ScanComments(mLines[currentLine], state);
+
+			// past the edited lines and the incoming state is unchanged: the rest is still valid
+			if (currentLine + 1 >= mCommentRangeMax && mLineStartStates[currentLine + 1] == state)
+				break;
+		}
+		if (currentLine == lineCount)
+			mLineStartStates[lineCount] = state;
+
+		mCommentRangeMin = std::numeric_limits<int>::max();
+		mCommentRangeMax = 0;
+		mCheckComments = false;
+	}
+
+	if (mHighlightJob.valid() && mHighlightJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		ApplyHighlightJob(mHighlightJob.get());
+
+	if (!mHighlightJob.valid() && mColorRangeMin < mColorRangeMax)
+		StartHighlightJob();
+}
+
+void TextEditor::StartHighlightJob()
+{
+	// The snapshot is copied on the UI thread, so a job covers a bounded chunk
+	// and the rest of the range waits for the following jobs.
+	static const int kMaxJobLines = 1024;
+
+	const int firstLine = mColorRangeMin;
+	const int rangeEnd = std::min((int)mLines.size(), mColorRangeMax);
+	const int endLine = std::min(rangeEnd, firstLine + kMaxJobLines);
+	if (endLine < rangeEnd)
+	{
+		mColorRangeMin = endLine;
+		mColorRangeMax = rangeEnd;
+	}
+	else
+	{
+		mColorRangeMin = std::numeric_limits<int>::max();
+		mColorRangeMax = 0;
+	}
+	if (firstLine >= endLine)
 		return;
+
+	HighlightJob job;
+	job.mVersion = mTextVersion;
+	job.mFirstLine = firstLine;
+	job.mTotalLines = (int)mLines.size();
+	job.mLines.assign(mLines.begin() + firstLine, mLines.begin() + endLine);
+
+	auto rules = mHighlightRules;
+	mHighlightJob = std::async(std::launch::async, [rules, job = std::move(job)]() mutable
+	{
+		ColorizeLines(*rules, job.mLines);
+		return std::move(job);
+	});
+}
+
+void TextEditor::ApplyHighlightJob(const HighlightJob& aJob)
+{
+	// Lines are tokenized independently, so a line whose text still matches the
+	// snapshot can take its colors even if other lines were edited meanwhile.
+	const bool unchanged = aJob.mVersion == mTextVersion;
+	int staleMin = std::numeric_limits<int>::max();
+	int staleMax = 0;
+	for (size_t i = 0; i < aJob.mLines.size(); ++i)
+	{
+		const int lineIndex = aJob.mFirstLine + (int)i;
+		const auto& colored = aJob.mLines[i];
+		bool matches = lineIndex < (int)mLines.size() && mLines[lineIndex].size() == colored.size();
+		if (matches && !unchanged)
+		{
+			const auto& line = mLines[lineIndex];
+			for (size_t j = 0; matches && j < line.size(); ++j)
+				matches = line[j].mChar == colored[j].mChar;
+		}
+		if (!matches)
+		{
+			staleMin = std::min(staleMin, lineIndex);
+			staleMax = lineIndex + 1;
+			continue;
+		}
+		auto& line = mLines[lineIndex];
+		for (size_t j = 0; j < line.size(); ++j)
+			line[j].mColorIndex = colored[j].mColorIndex;
+	}
+
+	// lines inserted since the snapshot push job lines past its end, and the
+	// chunks still queued behind it further down
+	const int grown = std::max(0, (int)mLines.size() - aJob.mTotalLines);
+	if (grown > 0 && mColorRangeMin < mColorRangeMax)
+		mColorRangeMax = std::min((int)mLines.size(), mColorRangeMax + grown);
+	if (grown > 0)
+	{
+		staleMin = std::min(staleMin, aJob.mFirstLine + (int)aJob.mLines.size());
+		staleMax = aJob.mFirstLine + (int)aJob.mLines.size() + grown;
+	}
+	if (staleMin < staleMax)
+	{
+		// queue the lines that changed under the job again
+		mColorRangeMin = std::min(mColorRangeMin, staleMin);
+		mColorRangeMax = std::max(mColorRangeMax, std::min((int)mLines.size(), staleMax));
 	}
 }
 
-float TextEditor::TextDistanceToLineStart(const Coordinates& aFrom) const
+const std::vector<float>& TextEditor::GetLineWidths(int aLine) const
 {
-	auto& line = mLines[aFrom.mLine];
+	const float fontSize = ImGui::GetFontSize();
+	if (fontSize != mLineWidthsFontSize || mTabSize != mLineWidthsTabSize)
+	{
+		mLineWidths.clear();
+		mLineWidthsFontSize = fontSize;
+		mLineWidthsTabSize = mTabSize;
+	}
+
+	auto& line = mLines[aLine];
+	auto cached = mLineWidths.find(aLine);
+	if (cached != mLineWidths.end() && cached->second.size() == line.size() + 1)
+		return cached->second;
+
+	// Only lines that have been on screen are cached; drop them all once scrolling has visited too many
+	if (cached == mLineWidths.end() && mLineWidths.size() >= 4096)
+		mLineWidths.clear();
+	auto& widths = mLineWidths[aLine];
+
+	// widths[i] is the x offset of glyph i; the trailing bytes of a UTF-8 sequence share the offset of its lead byte
+	widths.resize(line.size() + 1);
+	auto font = ImGui::GetFont();
+	float spaceSize = font->CalcTextSizeA(fontSize, FLT_MAX, -1.0f, " ", nullptr, nullptr).x;
 	float distance = 0.0f;
-	float spaceSize = ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, -1.0f, " ", nullptr, nullptr).x;
-	int colIndex = GetCharacterIndex(aFrom);
-	for (size_t it = 0u; it < line.size() && it < colIndex; )
+	for (size_t it = 0u; it < line.size(); )
 	{
+		widths[it] = distance;
 		if (line[it].mChar == '\t')
 		{
 			distance = (1.0f + std::floor((1.0f + distance) / (float(mTabSize) * spaceSize))) * (float(mTabSize) * spaceSize);
@@ -2406,15 +2912,38 @@ float TextEditor::TextDistanceToLineStart(const Coordinates& aFrom) const
 			auto d = UTF8CharLength(line[it].mChar);
 			char tempCString[7];
 			int i = 0;
-			for (; i < 6 && d-- > 0 && it < (int)line.size(); i++, it++)
+			for (; i < 6 && d-- > 0 && it < line.size(); i++, it++)
+			{
 				tempCString[i] = line[it].mChar;
+				widths[it] = distance;
+			}
 
 			tempCString[i] = '\0';
-			distance += ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, -1.0f, tempCString, nullptr, nullptr).x;
+			distance += font->CalcTextSizeA(fontSize, FLT_MAX, -1.0f, tempCString, nullptr, nullptr).x;
 		}
 	}
+	widths[line.size()] = distance;
+
+	return widths;
+}
+
+void TextEditor::InvalidateLineWidths(int aFromLine, int aToLine)
+{
+	if (aFromLine <= 0 && aToLine >= (int)mLines.size())
+	{
+		mLineWidths.clear();
+		return;
+	}
+
+	for (int i = std::max(0, aFromLine); i < aToLine; ++i)
+		mLineWidths.erase(i);
+}
 
-	return distance;
+float TextEditor::TextDistanceToLineStart(const Coordinates& aFrom) const
+{
+	auto& widths = GetLineWidths(aFrom.mLine);
+	int colIndex = std::min(GetCharacterIndex(aFrom), (int)widths.size() - 1);
+	return widths[colIndex];
 }
 
 void TextEditor::EnsureCursorVisible()
@@ -2478,43 +3007,45 @@ TextEditor::UndoRecord::UndoRecord(
 	assert(mRemovedStart <= mRemovedEnd);
 }
 
-void TextEditor::UndoRecord::Undo(TextEditor * aEditor)
+void TextEditor::ApplyUndo(const UndoEntry& aEntry)
 {
-	if (!mAdded.empty())
+	if (aEntry.mAddedLength > 0)
 	{
-		aEditor->DeleteRange(mAddedStart, mAddedEnd);
-		aEditor->Colorize(mAddedStart.mLine - 1, mAddedEnd.mLine - mAddedStart.mLine + 2);
+		DeleteRange(aEntry.mAddedStart, aEntry.mAddedEnd);
+		Colorize(aEntry.mAddedStart.mLine - 1, aEntry.mAddedEnd.mLine - aEntry.mAddedStart.mLine + 2);
 	}
 
-	if (!mRemoved.empty())
+	if (aEntry.mRemovedLength > 0)
 	{
-		auto start = mRemovedStart;
-		aEditor->InsertTextAt(start, mRemoved.c_str());
-		aEditor->Colorize(mRemovedStart.mLine - 1, mRemovedEnd.mLine - mRemovedStart.mLine + 2);
+		auto start = aEntry.mRemovedStart;
+		const std::string removed = mUndoText.substr(aEntry.mRemovedOffset, aEntry.mRemovedLength);
+		InsertTextAt(start, removed.c_str());
+		Colorize(aEntry.mRemovedStart.mLine - 1, aEntry.mRemovedEnd.mLine - aEntry.mRemovedStart.mLine + 2);
 	}
 
-	aEditor->mState = mBefore;
-	aEditor->EnsureCursorVisible();
+	mState = aEntry.mBefore;
+	EnsureCursorVisible();
 
 }
 
-void TextEditor::UndoRecord::Redo(TextEditor * aEditor)
+void TextEditor::ApplyRedo(const UndoEntry& aEntry)
 {
-	if (!mRemoved.empty())
+	if (aEntry.mRemovedLength > 0)
 	{
-		aEditor->DeleteRange(mRemovedStart, mRemovedEnd);
-		aEditor->Colorize(mRemovedStart.mLine - 1, mRemovedEnd.mLine - mRemovedStart.mLine + 1);
+		DeleteRange(aEntry.mRemovedStart, aEntry.mRemovedEnd);
+		Colorize(aEntry.mRemovedStart.mLine - 1, aEntry.mRemovedEnd.mLine - aEntry.mRemovedStart.mLine + 1);
 	}
 
-	if (!mAdded.empty())
+	if (aEntry.mAddedLength > 0)
 	{
-		auto start = mAddedStart;
-		aEditor->InsertTextAt(start, mAdded.c_str());
-		aEditor->Colorize(mAddedStart.mLine - 1, mAddedEnd.mLine - mAddedStart.mLine + 1);
+		auto start = aEntry.mAddedStart;
+		const std::string added = mUndoText.substr(aEntry.mAddedOffset, aEntry.mAddedLength);
+		InsertTextAt(start, added.c_str());
+		Colorize(aEntry.mAddedStart.mLine - 1, aEntry.mAddedEnd.mLine - aEntry.mAddedStart.mLine + 1);
 	}
 
-	aEditor->mState = mAfter;
-	aEditor->EnsureCursorVisible();
+	mState = aEntry.mAfter;
+	EnsureCursorVisible();
 }
 
 static bool TokenizeCStyleString(const char * in_begin, const char * in_end, const char *& out_begin, const char *& out_end)
@@ -2734,6 +3265,294 @@ static bool TokenizeCStylePunctuation(const char * in_begin, const char * in_end
 	return false;
 }
 
+// Matches a Lua long bracket opener "[", zero or more '=', "[" and returns its level, or -1.
+static int LuaLongBracketLevel(const char * in_begin, const char * in_end)
+{
+	const char * p = in_begin;
+	if (p >= in_end || *p != '[')
+		return -1;
+	p++;
+
+	int level = 0;
+	while (p < in_end && *p == '=')
+	{
+		level++;
+		p++;
+	}
+
+	return (p < in_end && *p == '[') ? level : -1;
+}
+
+// Scans from the opener to the matching "]=*]". An unterminated bracket runs to the end of the line.
+static const char * SkipLuaLongBracket(const char * in_begin, const char * in_end, int level)
+{
+	const char * p = in_begin + level + 2;
+
+	while (p < in_end)
+	{
+		if (*p == ']')
+		{
+			const char * q = p + 1;
+			int closing = 0;
+			while (q < in_end && *q == '=' && closing < level)
+			{
+				closing++;
+				q++;
+			}
+
+			if (closing == level && q < in_end && *q == ']')
+				return q + 1;
+		}
+		p++;
+	}
+
+	return in_end;
+}
+
+// Comment pass for languages with Lua long brackets. The tokenizer only sees one
+// line, so this marks the lines a --[==[ comment or [==[ string continues onto.
+// Quoted strings cannot span lines and are only tracked to keep "--" or "[["
+// inside them from opening anything.
+void TextEditor::ScanLongBrackets(Line& aLine, CommentScanState& aState)
+{
+	aState.mWithinSingleLineComment = false;
+
+	// reuse one buffer across lines instead of allocating a copy per rescan
+	mCommentScratch.resize(aLine.size());
+	for (size_t i = 0; i < aLine.size(); ++i)
+		mCommentScratch[i] = (char)aLine[i].mChar;
+	const char * begin = mCommentScratch.data();
+	const char * end = begin + mCommentScratch.size();
+
+	auto mark = [&](int aFrom, int aTo)
+	{
+		for (int i = aFrom; i < aTo && i < (int)aLine.size(); ++i)
+		{
+			auto& glyph = aLine[i];
+			glyph.mComment = aState.mWithinSingleLineComment;
+			glyph.mMultiLineComment = aState.mLongBracketLevel >= 0 && aState.mLongBracketComment;
+			glyph.mLongString = aState.mLongBracketLevel >= 0 && !aState.mLongBracketComment;
+			glyph.mPreprocessor = false;
+		}
+	};
+
+	char quote = 0;
+	int index = 0;
+	while (index < (int)aLine.size())
+	{
+		const char * p = begin + index;
+
+		if (aState.mLongBracketLevel >= 0)
+		{
+			// inside a long bracket: look for "]" followed by the same number of '=' and "]"
+			const int level = aState.mLongBracketLevel;
+			if (*p == ']' && end - p >= level + 2 && p[level + 1] == ']' &&
+				std::all_of(p + 1, p + 1 + level, [](char c) { return c == '='; }))
+			{
+				mark(index, index + level + 2);
+				index += level + 2;
+				aState.mLongBracketLevel = -1;
+			}
+			else
+			{
+				mark(index, index + 1);
+				++index;
+			}
+			continue;
+		}
+
+		if (aState.mWithinSingleLineComment)
+		{
+			mark(index, (int)aLine.size());
+			break;
+		}
+
+		if (quote != 0)
+		{
+			const int length = (*p == '\\' && index + 1 < (int)aLine.size()) ? 2 : 1;
+			if (*p == quote)
+				quote = 0;
+			mark(index, index + length);
+			index += length;
+			continue;
+		}
+
+		if (*p == '"' || *p == '\'')
+		{
+			quote = *p;
+			mark(index, index + 1);
+			++index;
+			continue;
+		}
+
+		// the long-bracket opener is checked before "--" so "--[[" starts a block comment
+		if (*p == '-' && end - p >= 2 && p[1] == '-')
+		{
+			const int level = LuaLongBracketLevel(p + 2, end);
+			if (level >= 0)
+			{
+				aState.mLongBracketLevel = level;
+				aState.mLongBracketComment = true;
+				mark(index, index + 2 + level + 2);
+				index += 2 + level + 2;
+			}
+			else
+				aState.mWithinSingleLineComment = true;
+			continue;
+		}
+
+		const int level = LuaLongBracketLevel(p, end);
+		if (level >= 0)
+		{
+			aState.mLongBracketLevel = level;
+			aState.mLongBracketComment = false;
+			mark(index, index + level + 2);
+			index += level + 2;
+			continue;
+		}
+
+		mark(index, index + 1);
+		++index;
+	}
+
+	aState.mWithinMultiLineComment = aState.mLongBracketLevel >= 0 && aState.mLongBracketComment;
+}
+
+static bool TokenizeLuaComment(const char * in_begin, const char * in_end, const char *& out_begin, const char *& out_end)
+{
+	if (in_end - in_begin < 2 || in_begin[0] != '-' || in_begin[1] != '-')
+		return false;
+
+	const int level = LuaLongBracketLevel(in_begin + 2, in_end);
+	out_begin = in_begin;
+	out_end = level >= 0 ? SkipLuaLongBracket(in_begin + 2, in_end, level) : in_end;
+	return true;
+}
+
+static bool TokenizeLuaString(const char * in_begin, const char * in_end, const char *& out_begin, const char *& out_end)
+{
+	const char * p = in_begin;
+	const char quote = *p;
+
+	if (quote == '"' || quote == '\'')
+	{
+		p++;
+
+		while (p < in_end)
+		{
+			if (*p == quote)
+			{
+				out_begin = in_begin;
+				out_end = p + 1;
+				return true;
+			}
+
+			// skip the escaped character, including \" and \'
+			if (*p == '\\' && p + 1 < in_end)
+				p++;
+
+			p++;
+		}
+
+		// unterminated string, color up to the end of the line
+		out_begin = in_begin;
+		out_end = in_end;
+		return true;
+	}
+
+	const int level = LuaLongBracketLevel(in_begin, in_end);
+	if (level >= 0)
+	{
+		out_begin = in_begin;
+		out_end = SkipLuaLongBracket(in_begin, in_end, level);
+		return true;
+	}
+
+	return false;
+}
+
+static bool TokenizeLuaNumber(const char * in_begin, const char * in_end, const char *& out_begin, const char *& out_end)
+{
+	const char * p = in_begin;
+
+	const bool startsWithDot = *p == '.';
+	if (startsWithDot && !(p + 1 < in_end && p[1] >= '0' && p[1] <= '9'))
+		return false;
+	if (!startsWithDot && !(*p >= '0' && *p <= '9'))
+		return false;
+
+	// hex numbers may have a fraction and a binary exponent (0x1.8p3)
+	const bool isHex = !startsWithDot && *p == '0' && p + 1 < in_end && (p[1] == 'x' || p[1] == 'X');
+	if (isHex)
+		p += 2;
+
+	auto isDigit = [isHex](char c)
+	{
+		return (c >= '0' && c <= '9') || (isHex && ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')));
+	};
+
+	while (p < in_end && (isDigit(*p) || *p == '.'))
+		p++;
+
+	const char exponentLower = isHex ? 'p' : 'e';
+	const char exponentUpper = isHex ? 'P' : 'E';
+	if (p < in_end && (*p == exponentLower || *p == exponentUpper))
+	{
+		p++;
+
+		if (p < in_end && (*p == '+' || *p == '-'))
+			p++;
+
+		while (p < in_end && *p >= '0' && *p <= '9')
+			p++;
+	}
+
+	out_begin = in_begin;
+	out_end = p;
+	return true;
+}
+
+static bool TokenizeLuaPunctuation(const char * in_begin, const char * in_end, const char *& out_begin, const char *& out_end)
+{
+	switch (*in_begin)
+	{
+	case '[':
+	case ']':
+	case '{':
+	case '}':
+	case '(':
+	case ')':
+	case '#':
+	case '%':
+	case '^':
+	case '&':
+	case '*':
+	case '-':
+	case '+':
+	case '=':
+	case '~':
+	case '|':
+	case '<':
+	case '>':
+	case ':':
+	case '/':
+	case ';':
+	case ',':
+		out_begin = in_begin;
+		out_end = in_begin + 1;
+		return true;
+	case '.':
+		// keep ".." and "..." together so "a..5" does not lex as a + .5
+		out_begin = in_begin;
+		out_end = in_begin + 1;
+		while (out_end < in_end && out_end - in_begin < 3 && *out_end == '.')
+			out_end++;
+		return true;
+	}
+
+	return false;
+}
+
 const TextEditor::LanguageDefinition& TextEditor::LanguageDefinition::CPlusPlus()
 {
 	static bool inited = false;
@@ -3136,17 +3955,37 @@ const TextEditor::LanguageDefinition& TextEditor::LanguageDefinition::Lua()
 			langDef.mIdentifiers.insert(std::make_pair(std::string(k), id));
 		}
 
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("L?\\\"(\\\\.|[^\\\"])*\\\"", PaletteIndex::String));
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("\\\'[^\\\']*\\\'", PaletteIndex::String));
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("0[xX][0-9a-fA-F]+[uU]?[lL]?[lL]?", PaletteIndex::Number));
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("[+-]?([0-9]+([.][0-9]*)?|[.][0-9]+)([eE][+-]?[0-9]+)?[fF]?", PaletteIndex::Number));
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("[+-]?[0-9]+[Uu]?[lL]?[lL]?", PaletteIndex::Number));
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("[a-zA-Z_][a-zA-Z0-9_]*", PaletteIndex::Identifier));
-		langDef.mTokenRegexStrings.push_back(std::make_pair<std::string, PaletteIndex>("[\\[\\]\\{\\}\\!\\%\\^\\&\\*\\(\\)\\-\\+\\=\\~\\|\\<\\>\\?\\/\\;\\,\\.]", PaletteIndex::Punctuation));
+		langDef.mTokenize = [](const char * in_begin, const char * in_end, const char *& out_begin, const char *& out_end, PaletteIndex & paletteIndex) -> bool
+		{
+			paletteIndex = PaletteIndex::Max;
+
+			while (in_begin < in_end && isascii(*in_begin) && isblank(*in_begin))
+				in_begin++;
+
+			if (in_begin == in_end)
+			{
+				out_begin = in_end;
+				out_end = in_end;
+				paletteIndex = PaletteIndex::Default;
+			}
+			else if (TokenizeLuaComment(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Comment;
+			else if (TokenizeLuaString(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::String;
+			else if (TokenizeCStyleIdentifier(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Identifier;
+			else if (TokenizeLuaNumber(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Number;
+			else if (TokenizeLuaPunctuation(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Punctuation;
+
+			return paletteIndex != PaletteIndex::Max;
+		};
 
 		langDef.mCommentStart = "--[[";
 		langDef.mCommentEnd = "]]";
 		langDef.mSingleLineComment = "--";
+		langDef.mLongBrackets = true;
 
 		langDef.mCaseSensitive = true;
 		langDef.mAutoIndentation = false;
@@ -8,13 +8,14 @@
 #include <unordered_map>
 #include <map>
 #include <regex>
+#include <future>
 #include  <cstdint>
 #include "imgui.h"
 
 class TextEditor
 {
 public:
-	enum class PaletteIndex
+	enum class PaletteIndex : uint8_t
 	{
 		Default,
 		Keyword,
@@ -37,6 +38,7 @@ public:
 		CurrentLineFill,
 		CurrentLineFillInactive,
 		CurrentLineEdge,
+		FindMatch,
 		Max
 	};
 
@@ -134,6 +136,8 @@ public:
 	typedef std::array<ImU32, (unsigned)PaletteIndex::Max> Palette;
 	typedef uint8_t Char;
 
+	// Three bytes per character: the byte itself, its palette index and the
+	// comment/preprocessor flags.
 	struct Glyph
 	{
 		Char mChar;
@@ -141,11 +145,19 @@ public:
 		bool mComment : 1;
 		bool mMultiLineComment : 1;
 		bool mPreprocessor : 1;
+		bool mLongString : 1;
 
 		Glyph(Char aChar, PaletteIndex aColorIndex) : mChar(aChar), mColorIndex(aColorIndex),
-			mComment(false), mMultiLineComment(false), mPreprocessor(false) {}
+			mComment(false), mMultiLineComment(false), mPreprocessor(false), mLongString(false) {}
 	};
-
+	static_assert(sizeof(Glyph) == 3, "Glyph is expected to pack into three bytes");
+
+	// The text is one exact-sized Glyph array per line, not a piece table or
+	// rope: memory is about three times the file size plus a vector header and
+	// a heap block per line, and colors are stored inline rather than as runs.
+	// Inserting or erasing a line moves every later line header (O(lines)) but
+	// no text; an edit inside a line moves the rest of that line. The widget
+	// indexes mLines[line][column] everywhere, so the storage was kept.
 	typedef std::vector<Glyph> Line;
 	typedef std::vector<Line> Lines;
 
@@ -162,6 +174,7 @@ public:
 		std::string mCommentStart, mCommentEnd, mSingleLineComment;
 		char mPreprocChar;
 		bool mAutoIndentation;
+		bool mLongBrackets;		// Lua long brackets: --[==[ comments ]==] and [==[ strings ]==] spanning lines
 
 		TokenizeCallback mTokenize;
 
@@ -170,7 +183,7 @@ public:
 		bool mCaseSensitive;
 
 		LanguageDefinition()
-			: mPreprocChar('#'), mAutoIndentation(true), mTokenize(nullptr), mCaseSensitive(true)
+			: mPreprocChar('#'), mAutoIndentation(true), mLongBrackets(false), mTokenize(nullptr), mCaseSensitive(true)
 		{
 		}
 
@@ -198,6 +211,10 @@ public:
 	void Render(const char* aTitle, const ImVec2& aSize = ImVec2(), bool aBorder = false);
 	void SetText(const std::string& aText);
 	std::string GetText() const;
+	// Copies up to aSize bytes of text starting at line aLine, character index
+	// aIndex into aBuffer and advances the position; lines are followed by '\n'
+	// as in GetText(). Returns 0 once the end of the text is reached.
+	size_t ReadText(int& aLine, int& aIndex, char* aBuffer, size_t aSize) const;
 
 	void SetTextLines(const std::vector<std::string>& aLines);
 	std::vector<std::string> GetTextLines() const;
@@ -263,12 +280,40 @@ public:
 	void Undo(int aSteps = 1);
 	void Redo(int aSteps = 1);
 
+	// Undo history budget in bytes (text plus records). The oldest steps are dropped
+	// once it is exceeded; the most recent step is always kept.
+	void SetUndoMemoryLimit(size_t aBytes);
+	inline size_t GetUndoMemoryLimit() const { return mUndoMemoryLimit; }
+	size_t GetUndoMemoryUsage() const;
+
+	struct FindOptions
+	{
+		bool mMatchCase;
+		bool mWholeWord;
+		bool mRegex;
+
+		FindOptions() : mMatchCase(false), mWholeWord(false), mRegex(false) {}
+	};
+
+	// Matches are searched line by line and only for lines that are drawn or
+	// stepped through, so a query costs nothing for off-screen text.
+	// Returns false (and clears the query) when a regex does not compile.
+	bool SetFindQuery(const std::string& aQuery, const FindOptions& aOptions = FindOptions());
+	void ClearFindQuery();
+	inline bool HasFindQuery() const { return !mFindQuery.empty(); }
+	// Selects the next (or previous) match after the cursor, wrapping around the document.
+	bool FindNext(bool aBackwards = false);
+	// Replaces every match as one undo step; regex replacements may use $1.. groups.
+	// Returns the number of replacements.
+	int ReplaceAll(const std::string& aReplacement);
+
 	static const Palette& GetDarkPalette();
 	static const Palette& GetLightPalette();
 	static const Palette& GetRetroBluePalette();
 
 private:
 	typedef std::vector<std::pair<std::regex, PaletteIndex>> RegexList;
+	typedef std::vector<std::pair<int, int>> LineMatches;	// [start, end) glyph indices
 
 	struct EditorState
 	{
@@ -295,9 +340,6 @@ private:
 			TextEditor::EditorState& aBefore,
 			TextEditor::EditorState& aAfter);
 
-		void Undo(TextEditor* aEditor);
-		void Redo(TextEditor* aEditor);
-
 		std::string mAdded;
 		Coordinates mAddedStart;
 		Coordinates mAddedEnd;
@@ -310,12 +352,79 @@ private:
 		EditorState mAfter;
 	};
 
-	typedef std::vector<UndoRecord> UndoBuffer;
+	// UndoRecord as stored in the history: the added and removed text live in
+	// mUndoText, written in record order (removed text first), so dropping the
+	// oldest records frees a prefix of it.
+	struct UndoEntry
+	{
+		size_t mAddedOffset = 0;
+		size_t mAddedLength = 0;
+		Coordinates mAddedStart;
+		Coordinates mAddedEnd;
+
+		size_t mRemovedOffset = 0;
+		size_t mRemovedLength = 0;
+		Coordinates mRemovedStart;
+		Coordinates mRemovedEnd;
+
+		EditorState mBefore;
+		EditorState mAfter;
+	};
+
+	typedef std::vector<UndoEntry> UndoBuffer;
+
+	// State of the comment/string scanner at the start of a line. It is cached for
+	// every line so a rescan can start at the first edited line and stop once the
+	// state flowing into an unedited line matches its cached value.
+	struct CommentScanState
+	{
+		bool mWithinString = false;
+		bool mWithinMultiLineComment = false;
+		bool mWithinSingleLineComment = false;
+		bool mWithinPreproc = false;
+		bool mFirstChar = true;
+		bool mConcatenate = false;
+		int mLongBracketLevel = -1;			// level of the open long bracket, -1 outside one
+		bool mLongBracketComment = false;	// the open long bracket is a comment rather than a string
+
+		bool operator ==(const CommentScanState& o) const
+		{
+			return mWithinString == o.mWithinString && mWithinMultiLineComment == o.mWithinMultiLineComment &&
+				mWithinSingleLineComment == o.mWithinSingleLineComment && mWithinPreproc == o.mWithinPreproc &&
+				mFirstChar == o.mFirstChar && mConcatenate == o.mConcatenate &&
+				mLongBracketLevel == o.mLongBracketLevel && mLongBracketComment == o.mLongBracketComment;
+		}
+	};
+	typedef std::vector<CommentScanState> CommentScanStates;
+
+	// Immutable tokenizer inputs, shared with the highlighting worker.
+	struct HighlightRules
+	{
+		LanguageDefinition mLanguageDefinition;
+		RegexList mRegexList;
+	};
+
+	// Copies of a bounded chunk of lines to colorize, taken at mVersion. The
+	// worker fills in their color indices; they are applied to every line whose
+	// text still matches the copy, and the others are queued again.
+	struct HighlightJob
+	{
+		uint64_t mVersion = 0;
+		int mFirstLine = 0;
+		int mTotalLines = 0;
+		std::vector<Line> mLines;
+	};
 
 	void ProcessInputs();
 	void Colorize(int aFromLine = 0, int aCount = -1);
-	void ColorizeRange(int aFromLine = 0, int aToLine = 0);
+	static void ColorizeLines(const HighlightRules& aRules, std::vector<Line>& aLines);
 	void ColorizeInternal();
+	void StartHighlightJob();
+	void ApplyHighlightJob(const HighlightJob& aJob);
+	void ScanComments(Line& aLine, CommentScanState& aState);
+	void ScanLongBrackets(Line& aLine, CommentScanState& aState);
+	const std::vector<float>& GetLineWidths(int aLine) const;
+	void InvalidateLineWidths(int aFromLine, int aToLine);
 	float TextDistanceToLineStart(const Coordinates& aFrom) const;
 	void EnsureCursorVisible();
 	int GetPageSize() const;
@@ -326,6 +435,10 @@ private:
 	void DeleteRange(const Coordinates& aStart, const Coordinates& aEnd);
 	int InsertTextAt(Coordinates& aWhere, const char* aValue);
 	void AddUndo(UndoRecord& aValue);
+	bool CoalesceUndo(const UndoRecord& aValue);
+	void TrimUndo();
+	void ApplyUndo(const UndoEntry& aEntry);
+	void ApplyRedo(const UndoEntry& aEntry);
 	Coordinates ScreenPosToCoordinates(const ImVec2& aPosition) const;
 	Coordinates FindWordStart(const Coordinates& aFrom) const;
 	Coordinates FindWordEnd(const Coordinates& aFrom) const;
@@ -335,6 +448,7 @@ private:
 	int GetLineCharacterCount(int aLine) const;
 	int GetLineMaxColumn(int aLine) const;
 	bool IsOnWordBoundary(const Coordinates& aAt) const;
+	void FindInLine(int aLine, LineMatches& aMatches, const std::string* aReplacement = nullptr, std::vector<std::string>* aReplacements = nullptr) const;
 	void RemoveLine(int aStart, int aEnd);
 	void RemoveLine(int aIndex);
 	Line& InsertLine(int aIndex);
@@ -353,7 +467,9 @@ private:
 	Lines mLines;
 	EditorState mState;
 	UndoBuffer mUndoBuffer;
+	std::string mUndoText;
 	int mUndoIndex;
+	size_t mUndoMemoryLimit;
 
 	int mTabSize;
 	bool mOverwrite;
@@ -376,14 +492,28 @@ private:
 	Palette mPaletteBase;
 	Palette mPalette;
 	LanguageDefinition mLanguageDefinition;
-	RegexList mRegexList;
+	std::shared_ptr<const HighlightRules> mHighlightRules;
+	std::future<HighlightJob> mHighlightJob;
+	uint64_t mTextVersion;				// bumped by every Colorize() request
 
 	bool mCheckComments;
+	int mCommentRangeMin, mCommentRangeMax;
+	CommentScanStates mLineStartStates;	// one per line plus the state after the last line
+	std::string mCommentScratch;		// bytes of the line being scanned for long brackets
 	Breakpoints mBreakpoints;
 	ErrorMarkers mErrorMarkers;
 	ImVec2 mCharAdvance;
 	Coordinates mInteractiveStart, mInteractiveEnd;
 	std::string mLineBuffer;
+	std::string mFindQuery;
+	std::string mFindNeedle;			// mFindQuery, lowercased unless matching case
+	FindOptions mFindOptions;
+	std::regex mFindRegex;
+	mutable std::string mFindScratch;	// bytes of the line being searched
+	LineMatches mFindMatches;
+	mutable std::unordered_map<int, std::vector<float>> mLineWidths;	// per line: x offset of every glyph index, plus the line width
+	mutable float mLineWidthsFontSize;
+	mutable int mLineWidthsTabSize;
 	uint64_t mStartTime;
 
 	float mLastClick;